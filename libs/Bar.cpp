@@ -2,53 +2,96 @@
 
 const double EPSILON = 1e-9;
 const double MIN_TICKSIZE = 2 * __DBL_EPSILON__;
-double Bar::tick_size = MIN_TICKSIZE;
+const double MAX_TICKS = 9.2e18; // just below LLONG_MAX
+double Bar::tick_size = 0.0;
+std::atomic<int> Bar::n_keyed(0);
 
 Bar::Bar(double p, double v)
-    : volume(v)
+    : ticks(PriceToTicks(p)),
+      volume(v)
 {
-    price = tick_size <= MIN_TICKSIZE ? p : std::round(p / tick_size + EPSILON) * tick_size;
+    CountKeyed(ticks, 1);
 }
 
 Bar::Bar()
-    : Bar(0.0, 0.0)
+    : ticks(0),
+      volume(0.0)
 {
 }
 
+Bar Bar::FromTicks(long long t, double v)
+{
+    Bar bar;
+    bar.ticks = t;
+    bar.volume = v;
+    CountKeyed(t, 1);
+    return bar;
+}
+
+// integer image of a price that keeps it exact and orders as the price does, for books without a tick size.
+// it is the magnitude's bit pattern, negated for negative prices; neighbouring doubles are neighbouring keys,
+// so key distances carry no meaning in price and tick-based features need a tick size
+long long Bar::PriceToKey(double p)
+{
+    if (p >= __DBL_MAX__)
+        return LLONG_MAX;
+    if (p <= -__DBL_MAX__)
+        return LLONG_MIN;
+    const double magnitude = std::fabs(p);
+    long long bits;
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    return p < 0.0 ? -bits : bits;
+}
+
+// round a price to the nearest tick; prices are compared as whole numbers of ticks.
+// without a tick size, the price is kept exact as its key instead
+long long Bar::PriceToTicks(double p)
+{
+    if (!HasTickSize())
+        return PriceToKey(p);
+    double t = std::round(p / tick_size + EPSILON);
+    if (t >= MAX_TICKS)
+        return LLONG_MAX;
+    if (t <= -MAX_TICKS)
+        return LLONG_MIN;
+    return static_cast<long long>(t);
+}
+
 bool Bar::PriceSameAs(double p) const
 {
-    Bar newBar(p, 0.0);
-    return abs(price - newBar.price) < __DBL_EPSILON__;
+    return ticks == PriceToTicks(p);
 }
 
 bool Bar::PriceHigherThan(double p) const
 {
-    Bar newBar(p, 0.0);
-    return price > newBar.price - __DBL_EPSILON__;
+    return ticks > PriceToTicks(p);
 }
 
 bool Bar::PriceLowerThan(double p) const
 {
-    Bar newBar(p, 0.0);
-    return price < newBar.price + __DBL_EPSILON__;
+    return ticks < PriceToTicks(p);
 }
 
 bool Bar::PriceHigherEqual(double p) const
 {
-    return PriceHigherThan(p) || PriceSameAs(p);
+    return ticks >= PriceToTicks(p);
 }
 
 bool Bar::PriceLowerEqual(double p) const
 {
-    return PriceLowerThan(p) || PriceSameAs(p);
+    return ticks <= PriceToTicks(p);
 }
 
+// until a tick size is set, bars keep their prices exact as keys, which a tick size would read differently.
+// it may thus be set only while no bar with a non-zero price and no book made without it is alive
 void Bar::SetTickSize(double ts)
 {
-    if (tick_size > MIN_TICKSIZE)
+    if (HasTickSize())
         throw std::logic_error("Tick size cannot be set again as it has already been set to non zero value.");
     if (ts < MIN_TICKSIZE)
         throw std::invalid_argument("Tick size must be non-zero positive number.");
+    if (n_keyed.load())
+        throw std::logic_error("Tick size cannot be set while bars or books made without it are alive.");
     tick_size = ts;
 }
 
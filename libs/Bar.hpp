@@ -2,24 +2,58 @@
 #define microhedger_utilities_bar_hpp
 
 #include <vector>
+#include <atomic>
+#include <climits>
+#include <cstring>
 #include <boost/format.hpp>
 
 class Bar
 {
 private:
-    double price;
+    long long ticks; // price as a whole number of ticks, or its exact key without a tick size; saturates
     double volume;
 
-    static double tick_size;
+    static double tick_size; // 0 until set: prices are then kept exact, see PriceToKey
+    static std::atomic<int> n_keyed; // bars and books alive that hold prices stored as keys, see SetTickSize
+
+    // whether ticks t of a bar hold a key, which a tick size would read differently; empty bars and the
+    // bid and ask sentinels read the same either way. once a tick size is set no bar holds a key
+    inline static bool Keyed(long long t) { return !HasTickSize() && t != 0 && t != LLONG_MAX && t != LLONG_MIN; }
+    inline static void CountKeyed(long long t, int d)
+    {
+        if (Keyed(t))
+            n_keyed.fetch_add(d, std::memory_order_relaxed);
+    }
+    static long long PriceToKey(double p);
+    // the price whose key is k
+    inline static double KeyToPrice(long long k)
+    {
+        const long long bits = k < 0 ? -k : k;
+        double p;
+        std::memcpy(&p, &bits, sizeof(p));
+        return k < 0 ? -p : p;
+    }
 
 public:
     Bar(double p, double v);
     Bar();
-    ~Bar() {}
+    Bar(const Bar &other) : ticks(other.ticks), volume(other.volume) { CountKeyed(ticks, 1); }
+    Bar &operator=(const Bar &other)
+    {
+        CountKeyed(ticks, -1);
+        ticks = other.ticks;
+        volume = other.volume;
+        CountKeyed(ticks, 1);
+        return *this;
+    }
+    ~Bar() { CountKeyed(ticks, -1); }
+
+    static Bar FromTicks(long long t, double v);
 
-    inline double Price() const { return price; }
+    inline double Price() const { return TicksToPrice(ticks); }
+    inline long long Ticks() const { return ticks; }
     inline double Volume() const { return volume; }
-    inline bool IsEmptyBar() const { return abs(price) < tick_size / 2; }
+    inline bool IsEmptyBar() const { return ticks == 0; }
     inline bool IsEmptyVolume() const { return abs(volume) < __DBL_EPSILON__; }
     inline bool IsEmpty() const { return IsEmptyBar() && IsEmptyVolume(); }
 
@@ -30,10 +64,43 @@ public:
     bool PriceLowerEqual(double p) const;
 
     static void SetTickSize(double ts);
+    // books count themselves among the holders of keyed prices through KeyHolder
+    inline static void CountKeyHolder(int d) { n_keyed.fetch_add(d, std::memory_order_relaxed); }
     inline static double TickSize() { return tick_size; }
+    inline static bool HasTickSize() { return tick_size > 0.0; }
+    static long long PriceToTicks(double p);
+    inline static double TicksToPrice(long long t)
+    {
+        if (t == LLONG_MAX || t == LLONG_MIN)
+            return t == LLONG_MAX ? __DBL_MAX__ : -__DBL_MAX__;
+        return HasTickSize() ? t * tick_size : KeyToPrice(t);
+    }
 
     int ExecuteAgainst(double &v);
     void AddVolumesBy(double v);
+    inline void SetVolume(double v) { volume = v; }
+};
+
+// member of a book that counts it, while it lives, among the holders of keyed prices if it was made
+// without a tick size, so that Bar::SetTickSize cannot change how its prices are read
+class KeyHolder
+{
+private:
+    bool keyed;
+
+public:
+    KeyHolder() : keyed(!Bar::HasTickSize())
+    {
+        if (keyed)
+            Bar::CountKeyHolder(1);
+    }
+    KeyHolder(const KeyHolder &) : KeyHolder() {}
+    KeyHolder &operator=(const KeyHolder &) { return *this; }
+    ~KeyHolder()
+    {
+        if (keyed)
+            Bar::CountKeyHolder(-1);
+    }
 };
 
 const static Bar theBidBar = Bar(-__DBL_MAX__, __DBL_EPSILON__);
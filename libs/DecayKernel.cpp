@@ -0,0 +1,139 @@
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include "DecayKernel.hpp"
+#include "Bar.hpp"
+#ifdef MICROHEDGER_SIMD_DECAY
+#include <immintrin.h>
+#endif
+
+// relative error of FastExp against std::exp, checked in test_decay_kernel.cpp
+const double DecayKernel::TOLERANCE = 1e-14;
+
+// constants of the cephes exp: x = n * ln2 + r, |r| <= ln2 / 2, exp(r) = 1 + 2 r P(r^2) / (Q(r^2) - r P(r^2))
+static const double EXP_LO = -708.39; // below this exp(x) is subnormal and the factor is taken as 0
+static const double EXP_HI = 709.0;   // keeps n within the exponent range of a normal double
+static const double LOG2E = 1.4426950408889634073599;
+static const double C1 = 6.93145751953125E-1; // ln2 split in a high part exact in n * C1 ...
+static const double C2 = 1.42860682030941723212E-6; // ... and a low part
+static const double P0 = 1.26177193074810590878E-4;
+static const double P1 = 3.02994407707441961300E-2;
+static const double P2 = 9.99999999999999999910E-1;
+static const double Q0 = 3.00198505138664455042E-6;
+static const double Q1 = 2.52448340349684104192E-3;
+static const double Q2 = 2.27265548208155028766E-1;
+static const double Q3 = 2.00000000000000000009E0;
+
+// same operations in the same order as the vector lanes in Apply, so both give identical results
+double DecayKernel::FastExp(double x)
+{
+    if (x < EXP_LO)
+        return 0.0;
+    x = std::min(x, EXP_HI);
+    double n = floor(LOG2E * x + 0.5);
+    double r = x - n * C1;
+    r = r - n * C2;
+    double rr = r * r;
+    double px = r * ((P0 * rr + P1) * rr + P2);
+    double qx = ((Q0 * rr + Q1) * rr + Q2) * rr + Q3;
+    double e = 1.0 + 2.0 * (px / (qx - px));
+    // scale by 2^n by writing n straight into the exponent bits
+    long long bits = (static_cast<long long>(n) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return e * scale;
+}
+
+// decay factor of a single level at price p
+double DecayKernel::Factor(double p_mid, double p, double d_coef)
+{
+#ifdef MICROHEDGER_SIMD_DECAY
+    double dp = p_mid - p;
+    return FastExp(-d_coef * (dp * dp));
+#else
+    return exp(-d_coef * pow(p_mid - p, 2));
+#endif
+}
+
+// reference loop, the formula used by LOB::DecayOrders before the kernel existed
+void DecayKernel::ApplyScalar(const double *ps, double *vs, int n, double p_mid, double d_coef)
+{
+    for (int i = 0; i < n; i++)
+    {
+        double d_factor = exp(-d_coef * pow(p_mid - ps[i], 2));
+        // v = v * a = v + (a - 1) * v
+        vs[i] += (d_factor - 1) * vs[i];
+    }
+}
+
+void DecayKernel::Apply(const double *ps, double *vs, int n, double p_mid, double d_coef)
+{
+#ifdef MICROHEDGER_SIMD_DECAY
+    const __m256d pm = _mm256_set1_pd(p_mid);
+    const __m256d neg_d = _mm256_set1_pd(-d_coef);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d lo = _mm256_set1_pd(EXP_LO);
+    const __m256d hi = _mm256_set1_pd(EXP_HI);
+    const __m256d magic = _mm256_set1_pd(6755399441055744.0); // 1.5 * 2^52, turns a whole double into int64 bits
+    const __m256i bias = _mm256_set1_epi64x(1023);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d dp = _mm256_sub_pd(pm, _mm256_loadu_pd(ps + i));
+        __m256d x = _mm256_mul_pd(neg_d, _mm256_mul_pd(dp, dp));
+        __m256d underflow = _mm256_cmp_pd(x, lo, _CMP_LT_OQ);
+        x = _mm256_min_pd(x, hi);
+        __m256d nd = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(LOG2E), x), half));
+        __m256d r = _mm256_sub_pd(x, _mm256_mul_pd(nd, _mm256_set1_pd(C1)));
+        r = _mm256_sub_pd(r, _mm256_mul_pd(nd, _mm256_set1_pd(C2)));
+        __m256d rr = _mm256_mul_pd(r, r);
+        __m256d px = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(P0), rr), _mm256_set1_pd(P1));
+        px = _mm256_mul_pd(r, _mm256_add_pd(_mm256_mul_pd(px, rr), _mm256_set1_pd(P2)));
+        __m256d qx = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(Q0), rr), _mm256_set1_pd(Q1));
+        qx = _mm256_add_pd(_mm256_mul_pd(qx, rr), _mm256_set1_pd(Q2));
+        qx = _mm256_add_pd(_mm256_mul_pd(qx, rr), _mm256_set1_pd(Q3));
+        __m256d e = _mm256_add_pd(one, _mm256_mul_pd(two, _mm256_div_pd(px, _mm256_sub_pd(qx, px))));
+        __m256i ni = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(nd, magic)), _mm256_castpd_si256(magic));
+        __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(ni, bias), 52));
+        __m256d d_factor = _mm256_andnot_pd(underflow, _mm256_mul_pd(e, scale));
+        __m256d v = _mm256_loadu_pd(vs + i);
+        v = _mm256_add_pd(v, _mm256_mul_pd(_mm256_sub_pd(d_factor, one), v));
+        _mm256_storeu_pd(vs + i, v);
+    }
+    for (; i < n; i++)
+    {
+        double d_factor = Factor(p_mid, ps[i], d_coef);
+        vs[i] += (d_factor - 1) * vs[i];
+    }
+#else
+    ApplyScalar(ps, vs, n, p_mid, d_coef);
+#endif
+}
+
+const long long DecayTable::MAX_SIZE;
+
+// only built for a positive coefficient and a tick size set before the book
+DecayTable::DecayTable(double _d_coef)
+    : d_coef(_d_coef),
+      half_tick(Bar::TickSize() * 0.5)
+{
+    if (d_coef <= 0 || !Bar::HasTickSize())
+        return;
+    auto fs = std::make_shared<std::vector<double>>(1, 1.0);
+    for (long long i = 1; i < MAX_SIZE && fs->back() != 0.0; i++)
+        fs->push_back(exp(-d_coef * pow(i * half_tick, 2)));
+    factors = fs;
+}
+
+double DecayTable::Factor(long long k) const
+{
+    const std::vector<double> &fs = *factors;
+    k = k < 0 ? -k : k;
+    if (k < static_cast<long long>(fs.size()))
+        return fs[k];
+    if (fs.back() == 0.0) // factors have underflowed, and only get smaller further away
+        return 0.0;
+    return exp(-d_coef * pow(k * half_tick, 2));
+}
@@ -0,0 +1,48 @@
+#ifndef microhedger_utilities_decay_kernel_hpp
+#define microhedger_utilities_decay_kernel_hpp
+
+#include <vector>
+#include <memory>
+
+// decay of resting volumes, v = v * exp(-d_coef * (p_mid - p)^2), over contiguous arrays of prices and volumes.
+// the default build evaluates the exact scalar formula with std::exp. building with SIMD_DECAY=ON
+// (defines MICROHEDGER_SIMD_DECAY and compiles with -mavx2) runs an AVX2 kernel with a polynomial exp;
+// every decay factor is then within TOLERANCE (relative) of std::exp, and the scalar FastExp used for
+// loop tails and single levels returns bit-identical factors to the vector lanes
+class DecayKernel
+{
+public:
+    DecayKernel() {}
+    ~DecayKernel() {}
+
+    static const double TOLERANCE;
+
+    static double FastExp(double x);
+    static double Factor(double p_mid, double p, double d_coef);
+    static void ApplyScalar(const double *ps, double *vs, int n, double p_mid, double d_coef);
+    static void Apply(const double *ps, double *vs, int n, double p_mid, double d_coef);
+};
+
+// decay factors exp(-d_coef * (k * tick / 2)^2) indexed by k, twice the tick distance between a price and the mid.
+// with a tick size set on Bar the mid lies on the half-tick grid, so decay is a lookup instead of pow and exp.
+// the table serves only the coefficient it was built for. it is filled in full when built, up to MAX_SIZE or to where
+// factors underflow, and never changes afterwards, so that copies of a book on any thread can share it
+class DecayTable
+{
+private:
+    double d_coef;
+    double half_tick;
+    std::shared_ptr<const std::vector<double>> factors;
+
+public:
+    static const long long MAX_SIZE = 1 << 16; // larger distances are computed directly
+
+    DecayTable(double _d_coef = 0.0);
+    ~DecayTable() {}
+
+    inline bool Covers(double d) const { return factors && d == d_coef; }
+    double Factor(long long k) const;
+    inline long long Size() const { return factors ? static_cast<long long>(factors->size()) : 0; }
+};
+
+#endif
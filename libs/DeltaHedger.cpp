@@ -1,6 +1,8 @@
 #include "DeltaHedger.hpp"
+#include "LadderLOB.hpp"
 
-double DeltaHedger::Delta(double vol, const LOB &currLOB, double time) const
+template <class Book>
+double DeltaHedger::Delta(double vol, const Book &currLOB, double time) const
 {
     double d_opt = 0.0, d_stk = 0.0;
     for (auto &opt : options)
@@ -10,7 +12,8 @@ double DeltaHedger::Delta(double vol, const LOB &currLOB, double time) const
     return d_opt + d_stk;
 }
 
-double DeltaHedger::Gamma(double vol, const LOB &currLOB, double time) const
+template <class Book>
+double DeltaHedger::Gamma(double vol, const Book &currLOB, double time) const
 {
     double g_opt = 0.0;
     for (auto &opt : options)
@@ -27,7 +30,8 @@ void DeltaHedger::ClearOrderAndInventories()
     outstanding_order = Bar();
 }
 
-void DeltaHedger::ResetGammaContract(double time, const LOB &currLOB)
+template <class Book>
+void DeltaHedger::ResetGammaContract(double time, const Book &currLOB)
 {
     ClearOrderAndInventories();
     // buy/sell ATM straddles maturing 2 days later
@@ -37,7 +41,8 @@ void DeltaHedger::ResetGammaContract(double time, const LOB &currLOB)
     ReCalcGreeks(time, currLOB);
 }
 
-void DeltaHedger::ReCalcGreeks(double time, const LOB &currLOB)
+template <class Book>
+void DeltaHedger::ReCalcGreeks(double time, const Book &currLOB)
 {
     delta = Delta(implied_vol, currLOB, time);
     gamma = Gamma(implied_vol, currLOB, time);
@@ -60,7 +65,7 @@ bool DeltaHedger::IsMyOrderExecuted(const std::vector<std::vector<Bar>> &eos) co
             for (auto &o : os)
             {
                 // compare order o with outstanding order
-                bool same_p = abs(o.Price() - outstanding_order.Price()) < __DBL_EPSILON__;
+                bool same_p = o.Ticks() == outstanding_order.Ticks();
                 bool same_s = o.Volume() * outstanding_order.Volume() > 0;
                 if (same_p && same_s)
                 {
@@ -79,11 +84,12 @@ bool DeltaHedger::IsMyOrderExecuted(const std::vector<std::vector<Bar>> &eos) co
 // based on execution results of this quarter hedger knows his state
 // he then removes posted but unexecuted order (if any)
 // and submit new order based on current LOB
+template <class Book>
 void DeltaHedger::PostOrder(double &p,
                             double &v,
                             int &s,
                             const std::vector<std::vector<Bar>> &eos,
-                            const LOB &currLOB,
+                            const Book &currLOB,
                             double t_q)
 {
     if (abs(delta) < __DBL_EPSILON__)
@@ -122,4 +128,16 @@ void DeltaHedger::UpdateInventories(const std::vector<std::vector<Bar>> &eos)
         stocks.push_back(bar);                                   // update inventories
         outstanding_order = Bar(outstanding_order.Price(), 0.0); // reset order
     }
-}
\ No newline at end of file
+}
+
+// the books that paths simulate on
+template double DeltaHedger::Delta<LOB>(double, const LOB &, double) const;
+template double DeltaHedger::Gamma<LOB>(double, const LOB &, double) const;
+template void DeltaHedger::ResetGammaContract<LOB>(double, const LOB &);
+template void DeltaHedger::ReCalcGreeks<LOB>(double, const LOB &);
+template void DeltaHedger::PostOrder<LOB>(double &, double &, int &, const std::vector<std::vector<Bar>> &, const LOB &, double);
+template double DeltaHedger::Delta<LadderLOB>(double, const LadderLOB &, double) const;
+template double DeltaHedger::Gamma<LadderLOB>(double, const LadderLOB &, double) const;
+template void DeltaHedger::ResetGammaContract<LadderLOB>(double, const LadderLOB &);
+template void DeltaHedger::ReCalcGreeks<LadderLOB>(double, const LadderLOB &);
+template void DeltaHedger::PostOrder<LadderLOB>(double &, double &, int &, const std::vector<std::vector<Bar>> &, const LadderLOB &, double);
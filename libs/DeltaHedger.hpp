@@ -28,18 +28,24 @@ public:
     inline double getOrderVolume() const { return outstanding_order.Volume(); }
     inline double getOrderPrice() const { return outstanding_order.Price(); }
 
-    double Delta(double vol, const LOB &currLOB, double time) const;
-    double Gamma(double vol, const LOB &currLOB, double time) const;
+    // the hedger reads quotes alone, from a LOB or a LadderLOB
+    template <class Book>
+    double Delta(double vol, const Book &currLOB, double time) const;
+    template <class Book>
+    double Gamma(double vol, const Book &currLOB, double time) const;
     bool IsMyOrderExecuted(const std::vector<std::vector<Bar>> &eos) const;
 
     void ClearOrderAndInventories();
-    void ResetGammaContract(double time, const LOB &currLOB);
-    void ReCalcGreeks(double time, const LOB &currLOB);
+    template <class Book>
+    void ResetGammaContract(double time, const Book &currLOB);
+    template <class Book>
+    void ReCalcGreeks(double time, const Book &currLOB);
+    template <class Book>
     void PostOrder(double &p,                                           // [O] - price of hedger's order
                    double &v,                                           // [O] - volume of hedger's order
                    int &s,                                              // [O] - sign of hedger's order
                    const std::vector<std::vector<Bar>> &available_info, // [I] - executed orders
-                   const LOB &currLOB,                                  // [I] - current lob
+                   const Book &currLOB,                                 // [I] - current lob
                    double t_q                                           // [I] - frac of current quarter / hour
     );
     void UpdateInventories(const std::vector<std::vector<Bar>> &eos);
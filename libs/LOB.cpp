@@ -1,17 +1,218 @@
 #include <iostream>
+#include <algorithm>
+#include <functional>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
 #include "LOB.hpp"
+#include "DecayKernel.hpp"
 
-LOB::LOB()
+const int LevelChunk::CAPACITY;
+
+// chunks are searched from the back, where the best prices and most accesses are
+void BookSide::Find(int i, int &c, int &j) const
+{
+    int start = n_levels;
+    for (c = Chunks() - 1; c > 0; c--)
+    {
+        start -= chunks[c]->ticks.size();
+        if (i >= start)
+            break;
+    }
+    if (c == 0)
+        start = 0;
+    j = i - start;
+}
+
+LevelChunk &BookSide::Own(int c)
+{
+    if (chunks[c].chunk.use_count() > 1)
+        chunks[c].chunk = std::make_shared<LevelChunk>(*chunks[c].chunk);
+    chunks[c].summed = false;
+    return *chunks[c].chunk;
+}
+
+long long BookSide::Tick(int i) const
+{
+    int c, j;
+    Find(i, c, j);
+    return chunks[c]->ticks[j];
+}
+
+double BookSide::Volume(int i) const
+{
+    int c, j;
+    Find(i, c, j);
+    return chunks[c]->volumes[j];
+}
+
+int BookSide::EpochAt(int i) const
+{
+    int c, j;
+    Find(i, c, j);
+    return chunks[c]->epochs[j];
+}
+
+double &BookSide::VolumeRef(int i)
+{
+    int c, j;
+    Find(i, c, j);
+    return Own(c).volumes[j];
+}
+
+int &BookSide::EpochRef(int i)
+{
+    int c, j;
+    Find(i, c, j);
+    return Own(c).epochs[j];
+}
+
+// index of the first level not before t, in ascending or descending tick order
+int BookSide::LowerBound(long long t, bool descending) const
+{
+    int start = 0;
+    for (auto &chunk : chunks)
+    {
+        const auto &ts = chunk->ticks;
+        if (descending ? ts.back() <= t : ts.back() >= t)
+        {
+            const long long *it = descending
+                                                            ? std::lower_bound(ts.begin(), ts.end(), t, std::greater<long long>())
+                                                            : std::lower_bound(ts.begin(), ts.end(), t);
+            return start + static_cast<int>(it - ts.begin());
+        }
+        start += ts.size();
+    }
+    return n_levels;
+}
+
+void BookSide::PushBack(long long t, double v, int e)
+{
+    if (!chunks.size() || chunks.back()->ticks.size() >= LevelChunk::CAPACITY)
+        chunks.push_back(std::make_shared<LevelChunk>());
+    LevelChunk &chunk = Own(Chunks() - 1);
+    chunk.ticks.push_back(t);
+    chunk.volumes.push_back(v);
+    chunk.epochs.push_back(e);
+    n_levels++;
+}
+
+void BookSide::Insert(int i, long long t, double v, int e)
+{
+    if (i == n_levels)
+    {
+        PushBack(t, v, e);
+        return;
+    }
+    int c, j;
+    Find(i, c, j);
+    LevelChunk &chunk = Own(c);
+    chunk.ticks.insert(chunk.ticks.begin() + j, t);
+    chunk.volumes.insert(chunk.volumes.begin() + j, v);
+    chunk.epochs.insert(chunk.epochs.begin() + j, e);
+    n_levels++;
+    // split a full chunk in halves
+    if (chunk.ticks.size() > LevelChunk::CAPACITY)
+    {
+        const int half = LevelChunk::CAPACITY / 2;
+        std::shared_ptr<LevelChunk> rest = std::make_shared<LevelChunk>();
+        rest->ticks.assign(chunk.ticks.begin() + half, chunk.ticks.end());
+        rest->volumes.assign(chunk.volumes.begin() + half, chunk.volumes.end());
+        rest->epochs.assign(chunk.epochs.begin() + half, chunk.epochs.end());
+        chunk.ticks.resize(half);
+        chunk.volumes.resize(half);
+        chunk.epochs.resize(half);
+        chunks.insert(chunks.begin() + c + 1, rest);
+    }
+}
+
+void BookSide::Erase(int i)
+{
+    int c, j;
+    Find(i, c, j);
+    if (chunks[c]->ticks.size() == 1)
+        chunks.erase(chunks.begin() + c);
+    else
+    {
+        LevelChunk &chunk = Own(c);
+        chunk.ticks.erase(chunk.ticks.begin() + j);
+        chunk.volumes.erase(chunk.volumes.begin() + j);
+        chunk.epochs.erase(chunk.epochs.begin() + j);
+    }
+    n_levels--;
+}
+
+void BookSide::PopBack()
+{
+    if (chunks.back()->ticks.size() == 1)
+        chunks.pop_back();
+    else
+    {
+        LevelChunk &chunk = Own(Chunks() - 1);
+        chunk.ticks.pop_back();
+        chunk.volumes.pop_back();
+        chunk.epochs.pop_back();
+    }
+    n_levels--;
+}
+
+// remove the chunks that filtering has left without levels
+void BookSide::DropEmptyChunks()
+{
+    for (int c = Chunks() - 1; c >= 0; c--)
+        if (chunks[c]->ticks.empty())
+            chunks.erase(chunks.begin() + c);
+}
+
+// number of chunks held in common with another copy of the side
+int BookSide::SharedChunks(const BookSide &other) const
+{
+    int n = 0;
+    for (const ChunkRef &ref : chunks)
+        for (const ChunkRef &other_ref : other.chunks)
+            if (other_ref.chunk == ref.chunk)
+            {
+                n++;
+                break;
+            }
+    return n;
+}
+
+// only chunks holding a non-zero epoch are written to
+void BookSide::ResetEpochs()
+{
+    for (int c = 0; c < Chunks(); c++)
+    {
+        const auto &es = chunks[c]->epochs;
+        if (std::count(es.begin(), es.end(), 0) != es.size())
+        {
+            auto &es_own = Own(c).epochs;
+            std::fill(es_own.begin(), es_own.end(), 0);
+        }
+    }
+}
+
+template <class SafetyPolicy>
+BasicLOB<SafetyPolicy>::BasicLOB()
 {
-    bids.resize(0);
-    asks.resize(0);
     decay_coef = 0.0;
-    safety_check = false;
+    lazy_decay = false;
+    n_epochs = 0;
+    p_ref = 0.0;
+    total_bids = 0.0;
+    total_asks = 0.0;
+    depth_ticks = 0;
+    depth_bids.top = depth_asks.top = 0;
+    dust_volume = 0.0;
+    max_depth = 0;
+    MarkDepthStale();
 }
 
-LOB::LOB(const std::vector<double> &aps, const std::vector<double> &avs,
-         const std::vector<double> &bps, const std::vector<double> &bvs)
-    : LOB()
+template <class SafetyPolicy>
+BasicLOB<SafetyPolicy>::BasicLOB(const std::vector<double> &aps, const std::vector<double> &avs,
+                                 const std::vector<double> &bps, const std::vector<double> &bvs)
+    : BasicLOB()
 {
     if (aps.size() != avs.size() || bps.size() != bvs.size())
         throw std::invalid_argument("Price and volume vectors must have same size");
@@ -19,205 +220,537 @@ LOB::LOB(const std::vector<double> &aps, const std::vector<double> &avs,
     {
         std::vector<double> ps_tmp = i == 0 ? aps : bps;
         std::vector<double> vs_tmp = i == 0 ? avs : bvs;
-        std::vector<Bar> &bars = i == 0 ? asks : bids;
+        BookSide &side = i == 0 ? asks : bids;
         // sort ps_tmp while organising vs_tmp so that they are in the same order
         Utils::sortPairedVectors(ps_tmp, vs_tmp);
-        for (int j = 0; j < ps_tmp.size(); j++)
-            bars.push_back(Bar(ps_tmp[j], vs_tmp[j]));
+        // asks are stored from the highest price down
+        const int n = static_cast<int>(ps_tmp.size());
+        for (int j = 0; j < n; j++)
+        {
+            int k = i == 0 ? n - 1 - j : j;
+            side.PushBack(Bar::PriceToTicks(ps_tmp[k]), vs_tmp[k], 0);
+        }
     }
+    total_asks = SumSide(1);
+    total_bids = SumSide(-1);
 }
 
-LOB::LOB(double _d_coef,
-         const std::vector<double> &aps, const std::vector<double> &avs,
-         const std::vector<double> &bps, const std::vector<double> &bvs)
-    : LOB(aps, avs, bps, bvs)
+template <class SafetyPolicy>
+BasicLOB<SafetyPolicy>::BasicLOB(double _d_coef,
+                                 const std::vector<double> &aps, const std::vector<double> &avs,
+                                 const std::vector<double> &bps, const std::vector<double> &bvs)
+    : BasicLOB(aps, avs, bps, bvs)
 {
     decay_coef = _d_coef;
+    decay_table = DecayTable(decay_coef);
 }
 
 // getter functions to obtain a specific bar in the lob
-const Bar &LOB::getBarAt(int s, int pos) const
+template <class SafetyPolicy>
+Bar BasicLOB<SafetyPolicy>::getBarAt(int s, int pos) const
 {
     CheckUnsafeCall();
     if (!s)
         throw std::invalid_argument("Invalid sign; must be non-zero integer.");
-    const std::vector<Bar> &bars = s > 0 ? asks : bids;
-    int n_bars = static_cast<int>(bars.size());
+    const BookSide &side = Side(s);
+    int n_bars = side.Size();
     if (pos >= n_bars || pos < -n_bars)
         throw std::invalid_argument("Invalid bar position; out of boundary.");
-    std::vector<Bar>::const_iterator it_start = pos >= 0 ? bars.begin() : bars.end();
-    return *(it_start + pos);
+    // positions count in ascending prices on both sides; asks are stored the other way round
+    int idx = pos >= 0 ? pos : n_bars + pos;
+    idx = s > 0 ? n_bars - 1 - idx : idx;
+    Settle(s, idx);
+    return side.BarAt(idx);
 }
 
-double LOB::getVolumeAt(int s, int pos) const
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getVolumeAt(int s, int pos) const
 {
-    CheckUnsafeCall();
     return getBarAt(s, pos).Volume();
 }
 
-double LOB::getPriceAt(int s, int pos) const
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getPriceAt(int s, int pos) const
 {
-    CheckUnsafeCall();
     return getBarAt(s, pos).Price();
 }
 
-double LOB::getTotalVolume(int s) const
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getTotalVolume(int s) const
 {
     // CheckUnsafeCall();
     if (s == 0)
         return 0.0;
+    if (!n_epochs)
+        return s > 0 ? total_asks : total_bids;
+    SettleSide(s);
+    return SumSide(s);
+}
+
+// sum the volumes of one side in ascending prices
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::SumSide(int s) const
+{
+    double volume = 0.0;
+    const BookSide &side = Side(s);
+    if (s > 0)
+        for (int c = side.Chunks() - 1; c >= 0; c--)
+        {
+            const auto &vs = side.Chunk(c).volumes;
+            for (int i = vs.size() - 1; i >= 0; i--)
+                volume += vs[i];
+        }
+    else
+        for (int c = 0; c < side.Chunks(); c++)
+            for (double v : side.Chunk(c).volumes)
+                volume += v;
+    return volume;
+}
+
+// volume of side s less than k ticks behind its best price, settling those bars on the way;
+// with d, also rebuild the k distances of its profile
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::SumDepth(int s, int k, DepthProfile *d) const
+{
+    const BookSide &side = Side(s);
+    double *level = d ? d->level.data() : nullptr;
+    if (d)
+    {
+        std::fill(level, level + k, 0.0);
+        std::fill(d->cum.begin(), d->cum.begin() + k, 0.0);
+    }
+    if (!side.Size())
+        return 0.0;
+    const long long top = side.BackTick();
+    double volume = 0.0;
+    for (int i = side.Size() - 1; i >= 0; i--)
+    {
+        const long long dist = std::llabs(side.Tick(i) - top);
+        if (dist >= k)
+            break;
+        Settle(s, i);
+        volume += side.Volume(i);
+        if (d)
+            level[dist] += side.Volume(i);
+    }
+    if (d)
+        std::partial_sum(level, level + k, d->cum.begin());
+    return volume;
+}
+
+// keep depth profiles of the first k price ticks of each side, so that getDepth up to k is O(1); 0 drops them.
+// like getDepth, needs a tick size
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::setDepthProfile(int k)
+{
+    if (k > 0 && !Bar::HasTickSize())
+        throw std::logic_error("Depth profiles need a tick size.");
+    depth_ticks = std::max(k, 0);
+    for (DepthProfile *d : {&depth_bids, &depth_asks})
+    {
+        d->level.assign(depth_ticks, 0.0);
+        d->cum.assign(depth_ticks, 0.0);
+    }
+    MarkDepthStale();
+}
+
+// volume of side s within its first k price ticks, that is of the levels less than k ticks behind the best
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getDepth(int s, int k) const
+{
+    if (s == 0 || k <= 0)
+        return 0.0;
+    if (!Bar::HasTickSize())
+        throw std::logic_error("Depth in ticks needs a tick size.");
+    if (k > depth_ticks)
+        return SumDepth(s, k, nullptr);
+    DepthProfile &d = Depth(s);
+    if (d.stale)
+    {
+        SumDepth(s, depth_ticks, &d);
+        // an empty side has no best price to measure from, so its profile is rebuilt on every query
+        d.stale = !Side(s).Size();
+        d.top = d.stale ? 0 : Side(s).BackTick();
+    }
+    return d.cum[k - 1];
+}
+
+// chunk c of side s with its totals up to date, settling its bars first; first is the index of its first level.
+// the totals are cached in this book's reference to the chunk, which no other copy of the book writes to
+template <class SafetyPolicy>
+const ChunkRef &BasicLOB<SafetyPolicy>::SummedChunk(int s, int c, int first) const
+{
+    BookSide &side = Side(s);
+    if (n_epochs)
+        for (int j = 0; j < side.Chunk(c).ticks.size(); j++)
+            Settle(s, first + j);
+    const ChunkRef &ref = side.Ref(c);
+    if (!ref.summed)
+    {
+        const LevelChunk &chunk = *ref.chunk;
+        ref.sum_v = 0.0;
+        ref.sum_pv = 0.0;
+        for (int j = 0; j < chunk.ticks.size(); j++)
+        {
+            ref.sum_v += chunk.volumes[j];
+            ref.sum_pv += chunk.volumes[j] * Bar::TicksToPrice(chunk.ticks[j]);
+        }
+        ref.summed = true;
+    }
+    return ref;
+}
+
+// VWAP that a market order of sign s and volume v would get from the book as it stands, without changing it;
+// v_exe is set to the volume it would execute, less than v if the other side runs out.
+// whole chunks are taken from their totals, so only the last one reached is walked level by level
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getMarketOrderVWAP(int s, double v, double &v_exe) const
+{
+    if (s != -1 && s != 1)
+        throw std::invalid_argument("Invalid sign for market orders. Must be -1 or 1.");
+    v_exe = 0.0;
+    double pos_ttl = 0.0;
+    const BookSide &other_side = Side(-s);
+    int first = other_side.Size();
+    for (int c = other_side.Chunks() - 1; c >= 0 && v - v_exe > __DBL_EPSILON__; c--)
+    {
+        const int n = other_side.Chunk(c).ticks.size();
+        first -= n;
+        const ChunkRef &ref = SummedChunk(-s, c, first);
+        const LevelChunk &chunk = *ref.chunk;
+        if (v_exe + ref.sum_v <= v)
+        {
+            v_exe += ref.sum_v;
+            pos_ttl += ref.sum_pv;
+            continue;
+        }
+        // the best level of a chunk is at its back
+        for (int j = n - 1; j >= 0 && v - v_exe > __DBL_EPSILON__; j--)
+        {
+            double exe_v = std::min(chunk.volumes[j], v - v_exe);
+            v_exe += exe_v;
+            pos_ttl += exe_v * Bar::TicksToPrice(chunk.ticks[j]);
+        }
+    }
+    return std::abs(v_exe) > __DBL_EPSILON__ ? pos_ttl / v_exe : 0.0;
+}
+
+// volume a market order of sign s could execute at prices no worse than p, i.e. the other side's
+// volume at or below p for a buy order (s = -1) and at or above p for a sell order (s = 1)
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getVolumeUpTo(int s, double p) const
+{
+    if (s == 0)
+        return 0.0;
+    // compared as prices, since p need not lie on the tick grid
+    const BookSide &other_side = Side(-s);
+    auto within = [&](long long tick)
+    { return s > 0 ? Bar::TicksToPrice(tick) >= p : Bar::TicksToPrice(tick) <= p; };
     double volume = 0.0;
-    auto &bars = s > 0 ? asks : bids;
-    for (auto &b : bars)
-        volume += b.Volume();
+    int first = other_side.Size();
+    for (int c = other_side.Chunks() - 1; c >= 0; c--)
+    {
+        const int n = other_side.Chunk(c).ticks.size();
+        first -= n;
+        if (!within(other_side.Chunk(c).ticks.back()))
+            break;
+        const ChunkRef &ref = SummedChunk(-s, c, first);
+        const LevelChunk &chunk = *ref.chunk;
+        // the worst level of a chunk is at its front
+        if (within(chunk.ticks[0]))
+        {
+            volume += ref.sum_v;
+            continue;
+        }
+        for (int j = n - 1; j >= 0 && within(chunk.ticks[j]); j--)
+            volume += chunk.volumes[j];
+        break;
+    }
     return volume;
 }
 
-void LOB::CheckUnsafeCall() const
+// shift the profile by dv from distance |t - top| on, unless the best price has moved
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::AddToDepth(int s, long long t, double dv)
 {
-    if (safety_check && oneSideEmpty())
-        throw std::out_of_range("One side of the LOB is empty. Potential malfunction under market failure.");
+    DepthProfile &d = Depth(s);
+    if (d.stale)
+        return;
+    const BookSide &side = Side(s);
+    if (!side.Size() || side.BackTick() != d.top)
+    {
+        d.stale = true;
+        return;
+    }
+    const long long dist = std::llabs(t - d.top);
+    if (dist < depth_ticks)
+        d.level[dist] += dv;
+    for (long long j = dist; j < depth_ticks; j++)
+        d.cum[j] += dv;
+}
+
+// decay the profile of side s by the factor DecayOrders applies at each distance, so that decay leaves it current
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::DecayDepth(int s, double p_mid, double d_coef, bool use_table, long long mid2)
+{
+    DepthProfile &d = Depth(s);
+    if (!depth_ticks || d.stale)
+        return;
+    const BookSide &side = Side(s);
+    if (!side.Size() || side.BackTick() != d.top)
+    {
+        d.stale = true;
+        return;
+    }
+    double cum = 0.0;
+    for (int j = 0; j < depth_ticks; j++)
+    {
+        if (d.level[j] != 0.0)
+        {
+            // levels behind the best one lie further up for asks and further down for bids
+            const long long t = d.top + s * j;
+            double d_factor = use_table ? decay_table.Factor(2 * t - mid2)
+                                        : DecayKernel::Factor(p_mid, Bar::TicksToPrice(t), d_coef);
+            d.level[j] += (d_factor - 1) * d.level[j];
+        }
+        cum += d.level[j];
+        d.cum[j] = cum;
+    }
+}
+
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::MarkDepthStale()
+{
+    depth_bids.stale = true;
+    depth_asks.stale = true;
+}
+
+// locate a price of t ticks in one side of the lob (s = 1: asks; s = -1: bids) by binary search;
+// return the index in storage order where a bar at t is or would be inserted, and set found if it is there
+template <class SafetyPolicy>
+int BasicLOB<SafetyPolicy>::LocateTicks(int s, long long t, bool &found) const
+{
+    const BookSide &side = Side(s);
+    int idx = side.LowerBound(t, s > 0); // asks are stored with descending prices
+    found = idx < side.Size() && side.Tick(idx) == t;
+    return idx;
 }
 
 // check whether the current LOB contains orders at price p; returns 1 (sell orders) or -1 (buy orders)
-int LOB::ContainsPrice(double p) const
+template <class SafetyPolicy>
+int BasicLOB<SafetyPolicy>::ContainsPrice(double p) const
 {
     CheckUnsafeCall();
-    if (Bid().PriceLowerThan(p) && Ask().PriceHigherThan(p))
+    const long long t = Bar::PriceToTicks(p);
+    if (Bid().Ticks() < t && Ask().Ticks() > t)
         return 0;
-    const int sign = Bid().PriceHigherEqual(p) ? -1 : 1;
-    const std::vector<Bar> &bars = sign > 0 ? asks : bids;
-    for (auto bar : bars)
-    {
-        // tick size is best introduced as a parameter of class Bar
-        // and all other classes are agnostic about it
-        if (bar.PriceSameAs(p))
-            return sign;
-    }
-    return 0;
+    const int sign = Bid().Ticks() >= t ? -1 : 1;
+    bool found = false;
+    LocateTicks(sign, t, found);
+    return found ? sign : 0;
 }
 
 // return the location of a price in one side of the lob (s = 1: asks; s = -1: bids), in ascending order
-int LOB::PriceLocation(int s, double p) const
+template <class SafetyPolicy>
+int BasicLOB<SafetyPolicy>::PriceLocation(int s, double p) const
 {
     CheckUnsafeCall();
     if (s == 0)
         return -1;
-
-    const std::vector<Bar> &bars = s > 0 ? asks : bids;
-    int location = 0;
-    for (auto bar : bars)
-    {
-        if (bar.PriceHigherEqual(p))
-            break;
-        location++;
-    }
-    return location;
+    bool found = false;
+    int idx = LocateTicks(s, Bar::PriceToTicks(p), found);
+    // count the bars lower than p; on the ask side these are the ones after the located bar
+    return s > 0 ? asks.Size() - idx - found : idx;
 }
 
 // add a limit order of price p and volume v, with sign s (s = 1, an ask/sell order; s = -1, a bid/buy order)
-void LOB::AddLimitOrder(int s, double p, double v)
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::AddLimitOrder(int s, double p, double v)
 {
     CheckUnsafeCall();
     if (s == 0)
         return;
-    int state = ContainsPrice(p); // 0 (no orders at p), 1 (sell orders at p), -1 (buy orders at p)
-    state *= s;                   // 0 (insert new prices), 1 (increase vol in LOB), -1 (execute against existing bar)
-    if (state == 0)               // insert a new bar with price p
+    const long long t = Bar::PriceToTicks(p);
+    bool found = false;
+    BookSide &side = Side(s);
+    const int loc = LocateTicks(s, t, found);
+    if (found) // already exists a bar at price p on the same side of book -> add volume to existing bar
     {
-        std::vector<Bar> &bars = s > 0 ? asks : bids;
-        std::vector<Bar>::iterator it = bars.begin() + PriceLocation(s, p);
-        bars.insert(it, Bar(p, v));
+        Settle(s, loc);
+        double &vol = side.VolumeRef(loc);
+        if (queues)
+            MutableQueues().Push(s, t, v, vol);
+        vol += v;
+        AddToSide(s, t, v);
+        return;
     }
-    else if (state > 0) // already exists a bar at price p on the same side of book -> add volume to existing bar
+    BookSide &other_side = Side(-s);
+    const int loc_other = LocateTicks(-s, t, found);
+    if (!found) // insert a new bar with price p
     {
-        std::vector<Bar> &bars = s > 0 ? asks : bids;
-        std::vector<Bar>::iterator it = bars.begin() + PriceLocation(s, p);
-        auto &bar = *(it);
-        bar.AddVolumesBy(v);
+        side.Insert(loc, t, v, Epoch());
+        if (queues)
+            MutableQueues().Push(s, t, v, 0.0);
+        AddToSide(s, t, v);
+        return;
     }
-    else // exists a bar at price p on the other side of the book -> execute against the bar
-    {
-        // safety measure: make sure 2 sides never cross
-        if ((s > 0 && Bid().PriceHigherThan(p)) || (s < 0 && Ask().PriceLowerThan(p)))
-            throw std::invalid_argument("Cannot post sell/buy limit order greater than bid/ask price!");
+    // exists a bar at price p on the other side of the book -> execute against the bar
+    // safety measure: make sure 2 sides never cross
+    if ((s > 0 && Bid().Ticks() > t) || (s < 0 && Ask().Ticks() < t))
+        throw std::invalid_argument("Cannot post sell/buy limit order greater than bid/ask price!");
 
-        std::vector<Bar> &bars_other_side = s > 0 ? bids : asks;
-        std::vector<Bar>::iterator it = bars_other_side.begin() + PriceLocation(-s, p);
-        auto &bar = *(it);
-        bar.ExecuteAgainst(v);
-        if (abs(bar.Volume()) < __DBL_EPSILON__)
-        {
-            bars_other_side.erase(it);
-            if (v > __DBL_EPSILON__) // if there is outstanding volume, we need to add it to existing lob
-                AddLimitOrder(s, p, v);
-        }
+    Settle(-s, loc_other);
+    double &vol = other_side.VolumeRef(loc_other);
+    double exe_v = std::min(vol, v);
+    if (queues)
+        MutableQueues().Consume(-s, t, exe_v, vol);
+    vol -= exe_v;
+    v -= exe_v;
+    AddToSide(-s, t, -exe_v);
+    if (std::abs(vol) < __DBL_EPSILON__)
+    {
+        const double rest = vol;
+        other_side.Erase(loc_other);
+        if (queues)
+            MutableQueues().Clear(-s, t);
+        AddToSide(-s, t, -rest);
+        if (v > __DBL_EPSILON__) // if there is outstanding volume, we need to add it to existing lob
+            AddLimitOrder(s, p, v);
     }
 }
 
 // cancel a limit order of price and and volume v
-void LOB::CancelLimitOrder(int s, double p, double v)
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::CancelLimitOrder(int s, double p, double v)
 {
     CheckUnsafeCall();
-    int state = ContainsPrice(p); // 0 (no orders at p), 1 (sell orders at p), -1 (buy orders at p)
-    if (s * state <= 0)           // if no orders at the specified side, do nothing
+    if (s == 0)
         return;
-    std::vector<Bar> &bars = s > 0 ? asks : bids;
-    std::vector<Bar>::iterator it = bars.begin() + PriceLocation(s, p);
-    auto &bar = *(it);
-    bar.AddVolumesBy(-v);
-    if (bar.Volume() < __DBL_EPSILON__)
-        bars.erase(it);
+    bool found = false;
+    BookSide &side = Side(s);
+    const long long t = Bar::PriceToTicks(p);
+    const int loc = LocateTicks(s, t, found);
+    if (!found) // if no orders at the specified side, do nothing
+        return;
+    Settle(s, loc);
+    double &vol = side.VolumeRef(loc);
+    const double orig_vol = vol;
+    vol -= v;
+    if (vol < __DBL_EPSILON__)
+    {
+        // the whole bar goes, even when more than it holds is cancelled
+        side.Erase(loc);
+        if (queues)
+            MutableQueues().Clear(s, t);
+        AddToSide(s, t, -orig_vol);
+    }
+    else
+    {
+        if (queues)
+            MutableQueues().Trim(s, t, v, orig_vol);
+        AddToSide(s, t, -v);
+    }
 }
 
 // adjust the lob with an incoming market order of sign s (1: sell; -1: buy) and volume v
 // return how many orders are executed at what price, and VWAP as a double
-double LOB::AbsorbMarketOrder(std::vector<Bar> &eos,
-                              double &v,
-                              int s)
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::AbsorbMarketOrder(std::vector<Bar> &eos,
+                                                 double &v,
+                                                 int s)
 {
     CheckUnsafeCall();
     if (s != -1 && s != 1)
         throw std::invalid_argument("Invalid sign for market orders. Must be -1 or 1.");
     eos.resize(0);
-    double v_ttl = 0.0;
-    double pos_ttl = 0.0;
+    return Sweep(eos, v, s, s > 0 ? LLONG_MIN : LLONG_MAX);
+}
+
+// check an order as AbsorbGeneralOrder does and find the worst tick it may execute at; false if it does nothing
+template <class SafetyPolicy>
+bool BasicLOB<SafetyPolicy>::StartOrder(OrderType o_type, double p, int s, long long &t_limit) const
+{
+    CheckUnsafeCall();
+    if (s == 0)
+        return false;
+    switch (o_type)
+    {
+    case LIMITORDER:
+        t_limit = Bar::PriceToTicks(p);
+        return true;
+    case MARKETORDER:
+        if (s != -1 && s != 1)
+            throw std::invalid_argument("Invalid sign for market orders. Must be -1 or 1.");
+        t_limit = s > 0 ? LLONG_MIN : LLONG_MAX;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// match volume v of an order of sign s against the best level of the other side, as long as it is at
+// t_limit or better for the order; store the executed order in eo and leave the outstanding volume in v.
+// false once v is spent or no such level is left. dummy bars met on the way are cleaned up
+template <class SafetyPolicy>
+bool BasicLOB<SafetyPolicy>::FillBest(double &v, int s, long long t_limit, Bar &eo)
+{
     int s_other_side = -s;
-    std::vector<Bar> &bars_other_side = s_other_side > 0 ? asks : bids; // sell orders, otherside = bid; buy orders, otherside - asks
+    BookSide &other_side = Side(s_other_side); // sell orders, otherside = bid; buy orders, otherside - asks
 
-    // clean up dummy bars before exercising market order
-    std::vector<Bar>::iterator it0 = s_other_side > 0 ? bars_other_side.begin() : bars_other_side.end() - 1;
-    auto &bar0 = *(it0);
-    while (bars_other_side.size() && bar0.Volume() < __DBL_EPSILON__)
+    // the best price of either side is at the back, so consumed bars are popped in constant time
+    while (other_side.Size())
     {
-        bars_other_side.erase(it0);
-        if (bars_other_side.size())
+        const long long t = other_side.BackTick();
+        if (s > 0 ? t < t_limit : t > t_limit)
+            return false;
+        Settle(s_other_side, other_side.Size() - 1);
+        double &vol = other_side.VolumeRef(other_side.Size() - 1);
+        bool filled = false;
+        if (vol >= __DBL_EPSILON__)
         {
-            it0 = s_other_side > 0 ? bars_other_side.begin() : bars_other_side.end() - 1;
-            bar0 = *(it0);
+            if (v <= __DBL_EPSILON__)
+                return false;
+            double orig_v = v;
+            double executed_vol = std::min(vol, v);
+            if (queues)
+                MutableQueues().Consume(s_other_side, t, executed_vol, vol);
+            vol -= executed_vol;
+            v -= executed_vol;
+            AddToSide(s_other_side, t, -executed_vol);
+            eo = Bar::FromTicks(t, s_other_side * (orig_v - v));
+            filled = true;
         }
-        else
-            break;
+        if (vol < __DBL_EPSILON__)
+        {
+            const double rest = vol;
+            other_side.PopBack();
+            if (queues)
+                MutableQueues().Clear(s_other_side, t);
+            AddToSide(s_other_side, t, -rest);
+        }
+        if (filled)
+            return true;
     }
+    return false;
+}
 
-    while (v > __DBL_EPSILON__ && bars_other_side.size())
+// match volume v of an order of sign s against the other side, best level first, as long as the level
+// is at t_limit or better for the order; append the executed orders to eos, leave the outstanding volume
+// in v and return the VWAP of what was executed
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::Sweep(std::vector<Bar> &eos, double &v, int s, long long t_limit)
+{
+    double v_ttl = 0.0;
+    double pos_ttl = 0.0;
+    Bar eo;
+    while (FillBest(v, s, t_limit, eo))
     {
-        double orig_v = v;
-        // if otherside is ask, execute from the beginning; otherwise from the end
-        std::vector<Bar>::iterator it = s_other_side > 0 ? bars_other_side.begin() : bars_other_side.end() - 1;
-        auto &bar = *(it);
-        bar.ExecuteAgainst(v);
-
-        // record executed orders
-        double exe_v = orig_v - v;
+        double exe_v = std::abs(eo.Volume());
         v_ttl += exe_v;
-        pos_ttl += exe_v * bar.Price();
-        eos.push_back(Bar(bar.Price(), s_other_side * exe_v));
-
-        if (bar.Volume() < __DBL_EPSILON__)
-            bars_other_side.erase(it);
+        pos_ttl += exe_v * eo.Price();
+        eos.push_back(eo);
     }
-    return abs(v_ttl) > __DBL_EPSILON__ ? pos_ttl / v_ttl : 0.0;
+    return std::abs(v_ttl) > __DBL_EPSILON__ ? pos_ttl / v_ttl : 0.0;
 }
 
 // pretty print the lob in the following format
@@ -225,21 +758,24 @@ double LOB::AbsorbMarketOrder(std::vector<Bar> &eos,
     price   1.1 1.5 3.2 4.1 4.5 5.2
     volume  -1  -4  -2   2   4   1
 */
-void LOB::PrintLOB() const
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::PrintLOB() const
 {
     std::string title = " Current limit order book ";
+    SettleSide(1);
+    SettleSide(-1);
     std::string p_row = "price\t";
     std::string v_row = "volume\t";
     // REPLACED: accuracy in format should be inline with tick size
-    for (auto bar : bids)
+    for (int i = 0; i < bids.Size(); i++)
     {
-        p_row += boost::str(boost::format("%1$.1f\t") % bar.Price());
-        v_row += boost::str(boost::format("%1$.1f\t") % -bar.Volume());
+        p_row += boost::str(boost::format("%1$.1f\t") % Bar::TicksToPrice(bids.Tick(i)));
+        v_row += boost::str(boost::format("%1$.1f\t") % -bids.Volume(i));
     }
-    for (auto bar : asks)
+    for (int i = asks.Size() - 1; i >= 0; i--)
     {
-        p_row += boost::str(boost::format("%1$.1f\t") % bar.Price());
-        v_row += boost::str(boost::format("%1$.1f\t") % bar.Volume());
+        p_row += boost::str(boost::format("%1$.1f\t") % Bar::TicksToPrice(asks.Tick(i)));
+        v_row += boost::str(boost::format("%1$.1f\t") % asks.Volume(i));
     }
     int length = std::max(p_row.length(), v_row.length());
     int nchar1 = std::max(int(length - title.size()) / 2, 0);
@@ -251,80 +787,394 @@ void LOB::PrintLOB() const
 }
 
 // decay resting orders in current LOB with a decay coefficient
-void LOB::DecayOrders(double d_coef)
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::DecayOrders(double d_coef)
 {
     CheckUnsafeCall();
+    // no decay leaves the book as it is, along with the chunks it shares with its copies;
+    // a negative coefficient still grows the volumes
+    if (d_coef == 0.0)
+        return;
     double p_mid = mid();
-    for (int i = 0; i < 2; i++)
+    // lazy mode only logs the decay; bars settle it when they are next read.
+    // without a two-sided mid the totals would overflow, so decay eagerly instead
+    if (lazy_decay && !oneSideEmpty())
     {
-        auto &bars = i == 0 ? asks : bids;
-        for (auto &bar : bars)
+        if (!n_epochs)
+            p_ref = p_mid;
+        DecayEpoch e = n_epochs ? (*decay_log)[n_epochs - 1] : DecayEpoch{0.0, 0.0, 0.0};
+        double dm = p_mid - p_ref;
+        e.coef += d_coef;
+        e.lin += d_coef * dm;
+        e.quad += d_coef * dm * dm;
+        LogDecay(e);
+        // bars settle the log with the exponent clamped at zero, which only a negative coefficient reaches
+        if (d_coef < 0)
+            MarkDepthStale();
+        DecayDepth(1, p_mid, d_coef, false, 0);
+        DecayDepth(-1, p_mid, d_coef, false, 0);
+        return;
+    }
+    Materialize();
+    // totals are recounted as each side decays, chunk by chunk in ascending prices as in SumSide
+    const bool use_table = decay_table.Covers(d_coef) && !oneSideEmpty();
+    // the mid is on the half-tick grid: twice its distance to a bar is a whole number of ticks
+    const long long mid2 = Bar::HasTickSize() && !oneSideEmpty() ? bids.BackTick() + asks.BackTick() : 0;
+    const bool prune = dust_volume > 0.0 || (max_depth && !oneSideEmpty());
+    // a chunk shared with a copy of the book is cloned before its volumes decay in place;
+    // prices are expanded from ticks, a chunk at a time, for the decay kernel
+    double ps[LevelChunk::CAPACITY + 1];
+    for (int s = 1; s >= -1; s -= 2)
+    {
+        BookSide &side = Side(s);
+        double volume = 0.0;
+        DecayDepth(s, p_mid, d_coef, use_table, mid2);
+        for (int k = 0; k < side.Chunks(); k++)
         {
-            double d_factor = exp(-d_coef * pow(p_mid - bar.Price(), 2));
-            // v = v * a = v + (a - 1) * v
-            bar.AddVolumesBy((d_factor - 1) * bar.Volume());
+            const int c = s > 0 ? side.Chunks() - 1 - k : k;
+            LevelChunk &own = side.MutableChunk(c);
+            const int n = own.ticks.size();
+            if (use_table)
+                for (int j = 0; j < n; j++)
+                {
+                    double d_factor = decay_table.Factor(2 * own.ticks[j] - mid2);
+                    // v = v * a = v + (a - 1) * v
+                    own.volumes[j] += (d_factor - 1) * own.volumes[j];
+                }
+            else
+            {
+                for (int j = 0; j < n; j++)
+                    ps[j] = Bar::TicksToPrice(own.ticks[j]);
+                DecayKernel::Apply(ps, own.volumes.data(), n, p_mid, d_coef);
+            }
+            if (prune)
+                PruneChunk(s, c, mid2);
+            const LevelChunk &chunk = side.Chunk(c);
+            const int m = chunk.ticks.size();
+            if (s > 0)
+                for (int j = m - 1; j >= 0; j--)
+                    volume += chunk.volumes[j];
+            else
+                for (int j = 0; j < m; j++)
+                    volume += chunk.volumes[j];
         }
+        if (prune)
+            side.DropEmptyChunks();
+        Total(s) = volume;
     }
 }
 
-void LOB::DecayOrders()
+// drop the levels of chunk c of side s that have decayed to dust or drifted beyond max_depth ticks
+// from the mid at 2 * mid2; the best level always stays, so that decay never empties a side
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::PruneChunk(int s, int c, long long mid2)
+{
+    BookSide &side = Side(s);
+    const LevelChunk &chunk = side.Chunk(c);
+    const int best = c == side.Chunks() - 1 ? static_cast<int>(chunk.ticks.size()) - 1 : -1;
+    const bool bounded = max_depth && !oneSideEmpty();
+    side.Filter(c, [&](int j)
+                {
+                    if (j == best)
+                        return true;
+                    const long long t = chunk.ticks[j];
+                    if (chunk.volumes[j] >= dust_volume && (!bounded || std::llabs(2 * t - mid2) <= 2LL * max_depth))
+                        return true;
+                    if (queues)
+                        MutableQueues().Clear(s, t);
+                    if (depth_ticks)
+                        AddToDepth(s, t, -chunk.volumes[j]);
+                    return false;
+                });
+}
+
+// drop levels during eager decay once their volume falls below dust, or once they lie more than
+// max_ticks ticks from mid if max_ticks is positive, which needs a tick size. this bounds the size of books that decay for long,
+// at the cost of the dropped volume; lazy decay settles levels only when read and prunes nothing
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::setPruning(double dust, int max_ticks)
+{
+    if (max_ticks > 0 && !Bar::HasTickSize())
+        throw std::logic_error("Pruning by distance in ticks needs a tick size.");
+    dust_volume = std::max(dust, 0.0);
+    max_depth = std::max(max_ticks, 0);
+}
+
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::DecayOrders()
 {
     DecayOrders(decay_coef);
 }
 
+// apply the decay logged since a bar was last settled
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::SettleLazy(int s, int idx) const
+{
+    BookSide &side = Side(s);
+    int &e0 = side.EpochRef(idx);
+    const std::vector<DecayEpoch> &log = *decay_log;
+    const DecayEpoch &now = log[n_epochs - 1];
+    DecayEpoch then = e0 ? log[e0 - 1] : DecayEpoch{0.0, 0.0, 0.0};
+    double q = Bar::TicksToPrice(side.Tick(idx)) - p_ref;
+    double expo = (now.quad - then.quad) - 2 * q * (now.lin - then.lin) + q * q * (now.coef - then.coef);
+    double d_factor = exp(-std::max(expo, 0.0)); // a sum of squares, up to rounding
+    double &vol = side.VolumeRef(idx);
+    vol += (d_factor - 1) * vol;
+    e0 = n_epochs;
+}
+
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::SettleSide(int s) const
+{
+    if (!n_epochs)
+        return;
+    for (int i = 0; i < Side(s).Size(); i++)
+        Settle(s, i);
+}
+
+// append to the shared log in place, unless a copy of the book has already appended past our end
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::LogDecay(const DecayEpoch &e)
+{
+    if (!decay_log)
+        decay_log = std::make_shared<std::vector<DecayEpoch>>();
+    else if (static_cast<int>(decay_log->size()) != n_epochs)
+        decay_log = std::make_shared<std::vector<DecayEpoch>>(decay_log->begin(), decay_log->begin() + n_epochs);
+    decay_log->push_back(e);
+    n_epochs++;
+}
+
+// settle every bar and restart the decay log; a no-op unless lazy decay is pending
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::Materialize()
+{
+    if (!n_epochs)
+        return;
+    SettleSide(1);
+    SettleSide(-1);
+    total_asks = SumSide(1);
+    total_bids = SumSide(-1);
+    decay_log.reset();
+    n_epochs = 0;
+    asks.ResetEpochs();
+    bids.ResetEpochs();
+}
+
+// in lazy mode DecayOrders only logs the decay of each epoch, and a bar catches up
+// when it is matched, cancelled, read or materialised
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::setLazyDecay(bool state)
+{
+    Materialize();
+    lazy_decay = state;
+}
+
 // update LOB and add order based on order type
 // return exercised limit order, sell/buy direction is marked by the sign of bar.volume
-std::vector<Bar> LOB::AbsorbGeneralOrder(OrderType o_type, double p, double v, int s)
+template <class SafetyPolicy>
+std::vector<Bar> BasicLOB<SafetyPolicy>::AbsorbGeneralOrder(OrderType o_type, double p, double v, int s)
 {
-    CheckUnsafeCall();
     std::vector<Bar> executed_orders;
+    AbsorbGeneralOrder(executed_orders, o_type, p, v, s);
+    return executed_orders;
+}
+
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::AbsorbGeneralOrder(std::vector<Bar> &eos, OrderType o_type, double p, double v, int s)
+{
+    CheckUnsafeCall();
+    eos.resize(0);
     if (s == 0)
-        return executed_orders;
+        return;
     switch (o_type)
     {
     case LIMITORDER:
     {
-        AbsorbLimitOrder(executed_orders, v, p, s);
+        AbsorbLimitOrder(eos, v, p, s);
         break;
     }
     case MARKETORDER:
     {
-        AbsorbMarketOrder(executed_orders, v, s);
+        AbsorbMarketOrder(eos, v, s);
         break;
     }
     default:
         break;
     }
-    return executed_orders;
 }
 
-void LOB::AbsorbLimitOrder(std::vector<Bar> &eos,
-                           double &v,
-                           double p,
-                           int s)
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::AbsorbLimitOrder(std::vector<Bar> &eos,
+                                              double &v,
+                                              double p,
+                                              int s)
+{
+    PostLimitOrder(eos, v, p, s);
+}
+
+// as AbsorbLimitOrder; with order queues on, return a handle to the volume left resting in the book
+template <class SafetyPolicy>
+OrderHandle BasicLOB<SafetyPolicy>::PostLimitOrder(std::vector<Bar> &eos,
+                                                   double &v,
+                                                   double p,
+                                                   int s)
 {
     CheckUnsafeCall();
+    OrderHandle h;
     if (s == 0)
+        return h;
+    eos.resize(0);
+    // an illegal LO, one that crosses the other side, executes against it up to its price first
+    const long long t = Bar::PriceToTicks(p);
+    Sweep(eos, v, s, t);
+    return Rest(v, t, s);
+}
+
+// rest the outstanding volume v of a limit order of sign s at tick t, once it no longer crosses the other side
+template <class SafetyPolicy>
+OrderHandle BasicLOB<SafetyPolicy>::Rest(double v, long long t, int s)
+{
+    OrderHandle h;
+    if (v > __DBL_EPSILON__)
+    {
+        bool found = false;
+        BookSide &side = Side(s);
+        const int loc = LocateTicks(s, t, found);
+        if (found)
+        {
+            Settle(s, loc);
+            double &vol = side.VolumeRef(loc);
+            if (queues)
+                h = MutableQueues().Push(s, t, v, vol);
+            vol += v;
+        }
+        else
+        {
+            side.Insert(loc, t, v, Epoch());
+            if (queues)
+                h = MutableQueues().Push(s, t, v, 0.0);
+        }
+        AddToSide(s, t, v);
+    }
+    return h;
+}
+
+// cancel an order posted with PostLimitOrder, whatever is left of it
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::CancelOrder(const OrderHandle &h)
+{
+    CheckUnsafeCall();
+    int s = 0;
+    long long t = 0;
+    if (!queues || !queues->Locate(h, s, t))
         return;
-    // handle illegal LO as market orders
-    bool illegalLO = (s > 0 && Bid().PriceHigherEqual(p)) || (s < 0 && Ask().PriceLowerEqual(p));
-    while (illegalLO && v > __DBL_EPSILON__)
+    bool found = false;
+    BookSide &side = Side(s);
+    const int loc = LocateTicks(s, t, found);
+    if (!found) // the level has left the book in a way that did not go through its queue
     {
-        double v_lo = -s > 0 ? Ask().Volume() : Bid().Volume();
-        double v_exe = std::min(v_lo, v);
-        v -= v_exe;
-        AbsorbMarketOrder(eos, v_exe, s);
-        illegalLO = (s > 0 && Bid().PriceHigherEqual(p)) || (s < 0 && Ask().PriceLowerEqual(p));
+        MutableQueues().Clear(s, t);
+        return;
     }
-    // exit the loop only when the order is fully executed or partially executed and legal
-    if (v > __DBL_EPSILON__)
+    Settle(s, loc);
+    double &vol = side.VolumeRef(loc);
+    const double orig_vol = vol;
+    const double v = MutableQueues().Remove(h, vol);
+    vol -= v;
+    if (vol < __DBL_EPSILON__)
     {
-        std::vector<Bar> &bars = s > 0 ? asks : bids;
-        std::vector<Bar>::iterator it = bars.begin() + PriceLocation(s, p);
-        auto &bar = *(it);
-        if (ContainsPrice(p))
-            bar.AddVolumesBy(v);
-        else
-            bars.insert(it, Bar(p, v));
+        side.Erase(loc);
+        MutableQueues().Clear(s, t);
+        AddToSide(s, t, -orig_vol);
     }
-}
\ No newline at end of file
+    else
+        AddToSide(s, t, -v);
+}
+
+// the order queues, cloned first if a copy of the book shares them
+template <class SafetyPolicy>
+OrderQueues &BasicLOB<SafetyPolicy>::MutableQueues()
+{
+    if (queues.use_count() > 1)
+        queues = std::make_shared<OrderQueues>(*queues);
+    return *queues;
+}
+
+// settled volume of the level at tick t of side s, 0 if there is none
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::LevelVolume(int s, long long t) const
+{
+    bool found = false;
+    const int loc = LocateTicks(s, t, found);
+    if (!found)
+        return 0.0;
+    Settle(s, loc);
+    return Side(s).Volume(loc);
+}
+
+// volume left of an order posted with PostLimitOrder; 0 once it is filled or cancelled
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getOrderVolume(const OrderHandle &h) const
+{
+    int s = 0;
+    long long t = 0;
+    if (!queues || !queues->Locate(h, s, t))
+        return 0.0;
+    return queues->Share(h) * LevelVolume(s, t);
+}
+
+// volume queued ahead of an order at its price, to be executed before it
+template <class SafetyPolicy>
+double BasicLOB<SafetyPolicy>::getVolumeAhead(const OrderHandle &h) const
+{
+    int s = 0;
+    long long t = 0;
+    if (!queues || !queues->Locate(h, s, t))
+        return 0.0;
+    return queues->ShareAhead(h) * LevelVolume(s, t);
+}
+
+// keep a FIFO queue of individual orders at every level, with room for capacity orders set aside;
+// turning them off drops every queue and invalidates all handles
+template <class SafetyPolicy>
+void BasicLOB<SafetyPolicy>::setOrderQueues(bool state, int capacity)
+{
+    if (state)
+        queues = std::make_shared<OrderQueues>(capacity);
+    else
+        queues.reset();
+}
+
+template <class SafetyPolicy>
+int BasicLOB<SafetyPolicy>::AbsorbOrders(const Order *orders, int n,
+                                         std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+{
+    for (int i = 0; i < n; i++)
+    {
+        DecayOrders();
+        if (!AbsorbTick(orders[i], mids, eos, eo_ends))
+            return i + 1;
+    }
+    return n;
+}
+
+// absorb one order of a batch, appending its executions straight to eos, and record the resulting mid
+// unless the order left a side empty
+template <class SafetyPolicy>
+bool BasicLOB<SafetyPolicy>::AbsorbTick(const Order &o, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+{
+    AbsorbGeneralOrder([&eos](const Bar &eo)
+                       { eos.push_back(eo); },
+                       o.type, o.p, o.v, o.s);
+    eo_ends.push_back(static_cast<int>(eos.size()));
+    if (oneSideEmpty())
+    {
+        CheckUnsafeCall();
+        return false;
+    }
+    mids.push_back(mid());
+    return true;
+}
+
+template class BasicLOB<UncheckedCalls>;
+template class BasicLOB<CheckedCalls>;
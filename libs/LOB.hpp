@@ -2,44 +2,256 @@
 #define microhedger_utilities_lob_hpp
 
 #include <vector>
+#include <memory>
+#include <stdexcept>
 #include "Bar.hpp"
 #include "Utils.hpp"
+#include "DecayKernel.hpp"
+#include "SmallVector.hpp"
+#include "OrderQueue.hpp"
+#include "SafetyPolicy.hpp"
 
-class LOB
+// running totals of decay since the last time the book was materialised, recorded once per decay epoch;
+// a bar at price p last settled at epoch e0 owes exp(-sum d (p_mid - p)^2) = exp(-(quad - 2 q lin + q^2 coef))
+// between the totals at e0 and now, with q = p - p_ref
+struct DecayEpoch
+{
+    double coef; // sum of d
+    double lin;  // sum of d * (p_mid - p_ref)
+    double quad; // sum of d * (p_mid - p_ref)^2
+};
+
+// a run of consecutive levels of one side as parallel arrays, so that passes over
+// prices or volumes alone stream through dense memory. the arrays are inline with room for one
+// level over capacity before the chunk is split, so a chunk is a single allocation
+struct LevelChunk
+{
+    static const int CAPACITY = 32;
+
+    SmallVector<long long, CAPACITY + 1> ticks; // price of each level in ticks
+    SmallVector<double, CAPACITY + 1> volumes;  // volume of each level
+    SmallVector<int, CAPACITY + 1> epochs;      // decay epoch at which each level was last settled
+};
+
+// a chunk as one copy of a side holds it. the chunk may be shared with other copies, read from other
+// threads, so the totals that queries cache are kept here, with the copy, and never in the chunk
+struct ChunkRef
+{
+    std::shared_ptr<LevelChunk> chunk;
+    // totals of volume and of volume * price over the chunk, filled in by queries on demand and
+    // valid while summed is set; every write through BookSide clears it
+    mutable double sum_v = 0.0;
+    mutable double sum_pv = 0.0;
+    mutable bool summed = false;
+
+    ChunkRef() {}
+    ChunkRef(const std::shared_ptr<LevelChunk> &c) : chunk(c) {}
+    inline LevelChunk *operator->() const { return chunk.get(); }
+};
+
+// one side of the book in storage order with the best price at the back, split into chunks of levels.
+// copies of a side share their chunks and clone one only when writing to it, so a snapshot of the
+// book owns just the chunks that changed since the book it was copied from
+class BookSide
+{
+public:
+    // number of chunks kept inline in the side, so that copying a book of up to
+    // INLINE_CHUNKS * LevelChunk::CAPACITY levels per side allocates nothing; deeper sides spill to the heap
+    static const int INLINE_CHUNKS = 2;
+
+private:
+    SmallVector<ChunkRef, INLINE_CHUNKS> chunks;
+    int n_levels;
+    KeyHolder keys; // keeps the tick size from changing under prices the side stored without one
+
+    void Find(int i, int &c, int &j) const; // chunk c and offset j of level i
+    LevelChunk &Own(int c);                 // chunk c, cloned first if another copy shares it
+
+public:
+    BookSide() : n_levels(0) {}
+    ~BookSide() {}
+
+    inline int Size() const { return n_levels; }
+    inline int Chunks() const { return static_cast<int>(chunks.size()); }
+    inline const LevelChunk &Chunk(int c) const { return *chunks[c].chunk; }
+    inline const ChunkRef &Ref(int c) const { return chunks[c]; }
+    inline LevelChunk &MutableChunk(int c) { return Own(c); }
+    inline long long BackTick() const { return chunks.back()->ticks.back(); }
+
+    long long Tick(int i) const;
+    double Volume(int i) const;
+    int EpochAt(int i) const;
+    double &VolumeRef(int i);
+    int &EpochRef(int i);
+    inline Bar BarAt(int i) const { return Bar::FromTicks(Tick(i), Volume(i)); }
+    int LowerBound(long long t, bool descending) const;
+
+    void PushBack(long long t, double v, int e);
+    void Insert(int i, long long t, double v, int e);
+    void Erase(int i);
+    void PopBack();
+    void ResetEpochs();
+    void DropEmptyChunks();
+    int SharedChunks(const BookSide &other) const;
+
+    // drop the levels j of chunk c for which keep(j) is false, leaving the chunk empty
+    // if none are kept; the chunk is only written to when a level goes
+    template <class Keep>
+    void Filter(int c, Keep keep)
+    {
+        const LevelChunk &chunk = *chunks[c].chunk;
+        const int n = chunk.ticks.size();
+        int j = 0;
+        while (j < n && keep(j))
+            j++;
+        if (j == n)
+            return;
+        LevelChunk &own = Own(c);
+        int kept = j;
+        for (j++; j < n; j++)
+            if (keep(j))
+            {
+                own.ticks[kept] = own.ticks[j];
+                own.volumes[kept] = own.volumes[j];
+                own.epochs[kept] = own.epochs[j];
+                kept++;
+            }
+        own.ticks.resize(kept);
+        own.volumes.resize(kept);
+        own.epochs.resize(kept);
+        n_levels -= n - kept;
+    }
+};
+
+// cumulative volume of one side by distance from its best price: cum[k - 1] is the volume of the
+// levels less than k ticks behind the best one. kept up to date while the best price holds, decay
+// included, which scales each distance by its factor; rebuilt on the next query once the best price moves
+struct DepthProfile
+{
+    std::vector<double> level; // volume at each distance
+    std::vector<double> cum;
+    long long top; // best tick the distances are measured from
+    bool stale;
+};
+
+// SafetyPolicy decides at compile time whether public calls check for market failure, see SafetyPolicy.hpp
+template <class SafetyPolicy>
+class BasicLOB
 {
 private:
     double decay_coef;
-    bool safety_check;
-    std::vector<Bar> bids; // all the buy orders with ascending prices
-    std::vector<Bar> asks; // all the sell orders with ascending prices
+    bool lazy_decay;
+    // sides are mutable so that const reads can settle pending lazy decay first
+    mutable BookSide bids;             // all the buy orders with ascending prices
+    mutable BookSide asks;             // all the sell orders with descending prices, so that the best ask sits at the back
+    // totals after each lazy decay; epoch e owes nothing before entry e - 1. copies of the book share
+    // the log, and entries past n_epochs belong to a copy that decayed further
+    std::shared_ptr<std::vector<DecayEpoch>> decay_log;
+    int n_epochs;
+    double p_ref;                      // reference price of decay_log, to keep the totals small
+    DecayTable decay_table;            // cached factors for decay_coef
+    // running total volume of each side, kept up to date by every order and recounted by decay;
+    // while lazy decay is pending they are stale until the book is materialised
+    double total_bids;
+    double total_asks;
+    int depth_ticks;                   // ticks covered by the depth profiles, or 0 when none are kept
+    mutable DepthProfile depth_bids;
+    mutable DepthProfile depth_asks;
+    // individual orders queued at each level, or none; copies of the book share them until either changes them
+    std::shared_ptr<OrderQueues> queues;
+    double dust_volume;                // levels decayed below this volume are dropped, see setPruning
+    int max_depth;                     // levels decayed further than this many ticks from mid are dropped, or 0
+
+    inline BookSide &Side(int s) const { return s > 0 ? asks : bids; }
+    inline double &Total(int s) { return s > 0 ? total_asks : total_bids; }
+    inline DepthProfile &Depth(int s) const { return s > 0 ? depth_asks : depth_bids; }
+    OrderQueues &MutableQueues();
+    // account for volume dv added at tick t of side s, once the side itself has been updated
+    inline void AddToSide(int s, long long t, double dv)
+    {
+        Total(s) += dv;
+        if (depth_ticks)
+            AddToDepth(s, t, dv);
+    }
+    void AddToDepth(int s, long long t, double dv);
+    void MarkDepthStale();
+    void DecayDepth(int s, double p_mid, double d_coef, bool use_table, long long mid2);
+    double SumSide(int s) const;
+    double SumDepth(int s, int k, DepthProfile *d) const;
+    const ChunkRef &SummedChunk(int s, int c, int first) const;
+    double LevelVolume(int s, long long t) const;
+    inline int Epoch() const { return n_epochs; }
+    inline void Settle(int s, int idx) const
+    {
+        if (n_epochs && Side(s).EpochAt(idx) != n_epochs)
+            SettleLazy(s, idx);
+    }
+    void SettleLazy(int s, int idx) const;
+    void SettleSide(int s) const;
+    void LogDecay(const DecayEpoch &e);
+    bool StartOrder(OrderType o_type, double p, int s, long long &t_limit) const;
+    bool FillBest(double &v, int s, long long t_limit, Bar &eo);
+    double Sweep(std::vector<Bar> &eos, double &v, int s, long long t_limit);
+    OrderHandle Rest(double v, long long t, int s);
+    void PruneChunk(int s, int c, long long mid2);
+    bool AbsorbTick(const Order &o, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends);
 
 public:
-    LOB();
-    LOB(const std::vector<double> &aps, const std::vector<double> &avs,
-        const std::vector<double> &bps, const std::vector<double> &bvs);
-    LOB(double _d_coef,
-        const std::vector<double> &aps, const std::vector<double> &avs,
-        const std::vector<double> &bps, const std::vector<double> &bvs);
-    ~LOB() {}
-
-    inline double bid() const { return bids.size() ? bids.back().Price() : -__DBL_MAX__; }
-    inline double ask() const { return asks.size() ? asks.front().Price() : __DBL_MAX__; }
+    BasicLOB();
+    BasicLOB(const std::vector<double> &aps, const std::vector<double> &avs,
+             const std::vector<double> &bps, const std::vector<double> &bvs);
+    BasicLOB(double _d_coef,
+             const std::vector<double> &aps, const std::vector<double> &avs,
+             const std::vector<double> &bps, const std::vector<double> &bvs);
+    ~BasicLOB() {}
+
+    inline double bid() const { return bids.Size() ? Bar::TicksToPrice(bids.BackTick()) : -__DBL_MAX__; }
+    inline double ask() const { return asks.Size() ? Bar::TicksToPrice(asks.BackTick()) : __DBL_MAX__; }
     inline double mid() const { return (ask() + bid()) * 0.5; }
-    inline const Bar &Bid() const { return bids.size() ? bids.back() : theBidBar; }
-    inline const Bar &Ask() const { return asks.size() ? asks.front() : theAskBar; }
-    inline bool oneSideEmpty() const { return !asks.size() || !bids.size(); }
-    inline bool bothSidesEmpty() const { return !asks.size() && !asks.size(); }
-    inline void setSafetyCheck(bool state) { safety_check = state; }
+    inline Bar Bid() const
+    {
+        if (!bids.Size())
+            return theBidBar;
+        Settle(-1, bids.Size() - 1);
+        return bids.BarAt(bids.Size() - 1);
+    }
+    inline Bar Ask() const
+    {
+        if (!asks.Size())
+            return theAskBar;
+        Settle(1, asks.Size() - 1);
+        return asks.BarAt(asks.Size() - 1);
+    }
+    inline bool oneSideEmpty() const { return !asks.Size() || !bids.Size(); }
+    inline bool bothSidesEmpty() const { return !asks.Size() && !asks.Size(); }
+    void setLazyDecay(bool state);
+    void Materialize();
 
-    const Bar &getBarAt(int s, int pos) const;
+    Bar getBarAt(int s, int pos) const;
     double getVolumeAt(int s, int pos) const;
     double getPriceAt(int s, int pos) const;
     
     double getTotalVolume(int s) const;
+    inline int getNumLevels(int s) const { return s ? Side(s).Size() : 0; }
+    void setDepthProfile(int k);
+    double getDepth(int s, int k) const;
+    inline bool hasCurrentDepth(int s) const { return depth_ticks && !Depth(s).stale; }
+    double getMarketOrderVWAP(int s, double v, double &v_exe) const;
+    double getVolumeUpTo(int s, double p) const;
+    void setOrderQueues(bool state, int capacity = 0);
+    void setPruning(double dust, int max_ticks = 0);
+    double getOrderVolume(const OrderHandle &h) const;
+    double getVolumeAhead(const OrderHandle &h) const;
+    inline int getSharedChunks(int s, const BasicLOB &other) const { return Side(s).SharedChunks(other.Side(s)); }
 
+    int LocateTicks(int s, long long t, bool &found) const;
     int ContainsPrice(double p) const;
     int PriceLocation(int s, double p) const;
-    void CheckUnsafeCall() const;
+    inline void CheckUnsafeCall() const
+    {
+        if (SafetyPolicy::ENABLED && oneSideEmpty())
+            throw std::out_of_range("One side of the LOB is empty. Potential malfunction under market failure.");
+    }
     void PrintLOB() const;
 
     void AddLimitOrder(int s, double p, double v);
@@ -51,6 +263,11 @@ public:
                           double &v,
                           double p,
                           int s);
+    OrderHandle PostLimitOrder(std::vector<Bar> &eos,
+                               double &v,
+                               double p,
+                               int s);
+    void CancelOrder(const OrderHandle &h);
     void DecayOrders(double d_coef);
     void DecayOrders();
     std::vector<Bar> AbsorbGeneralOrder(OrderType o_type, // [I] - order type
@@ -58,6 +275,60 @@ public:
                                         double v,         // [I] - volume of order
                                         int s             // [I] - sign of order
     );
+    // as above, but writes into a buffer owned by the caller, so that reusing it allocates nothing
+    void AbsorbGeneralOrder(std::vector<Bar> &eos, // [O] - executed orders, cleared first
+                            OrderType o_type,      // [I] - order type
+                            double p,              // [I] - price of order
+                            double v,              // [I] - volume of order
+                            int s                  // [I] - sign of order
+    );
+    // as above, but hands each executed order to sink(const Bar &) as it is matched instead of storing it
+    template <class Sink>
+    void AbsorbGeneralOrder(Sink &&sink, OrderType o_type, double p, double v, int s)
+    {
+        long long t_limit;
+        if (!StartOrder(o_type, p, s, t_limit))
+            return;
+        Bar eo;
+        while (FillBest(v, s, t_limit, eo))
+            sink(eo);
+        if (o_type == LIMITORDER)
+            Rest(v, t_limit, s);
+    }
+
+    // apply a run of orders, each one after a round of decay as in a simulated tick. the mid after every
+    // order is appended to mids and the executed orders of all of them to the single log eos, with
+    // eo_ends recording where each order's executions end in eos. the run stops at an order that empties
+    // a side of the book: its executions are logged but it gets no mid, and a checked book throws there.
+    // returns the number of orders absorbed
+    int AbsorbOrders(const Order *orders,          // [I] - orders to apply in turn
+                     int n,                        // [I] - number of orders
+                     std::vector<double> &mids,    // [O] - appended mid after each order
+                     std::vector<Bar> &eos,        // [O] - appended executed orders
+                     std::vector<int> &eo_ends     // [O] - appended end of each order's executions in eos
+    );
+    // as above, but each order is drawn by gen(Order &, double p_mid) from the mid after decay,
+    // for order flow that reacts to the book. a book that starts with an empty side draws nothing
+    template <class Gen>
+    int AbsorbOrderFlow(Gen &&gen, int n, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+    {
+        if (!SafetyPolicy::ENABLED && oneSideEmpty())
+            return 0;
+        for (int i = 0; i < n; i++)
+        {
+            DecayOrders();
+            Order o = {MARKETORDER, 0.0, 0.0, 0};
+            gen(o, mid());
+            if (!AbsorbTick(o, mids, eos, eo_ends))
+                return i + 1;
+        }
+        return n;
+    }
 };
 
+// the book of the simulation, which checks for market failure once per order itself
+typedef BasicLOB<UncheckedCalls> LOB;
+// a book whose every public call throws std::out_of_range once a side is empty
+typedef BasicLOB<CheckedCalls> CheckedLOB;
+
 #endif
@@ -0,0 +1,637 @@
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <climits>
+#include "LadderLOB.hpp"
+#include "DecayKernel.hpp"
+
+const long long PriceLadder::MIN_WINDOW;
+const long long PriceLadder::MAX_WINDOW;
+
+PriceLadder::PriceLadder(int _side)
+    : side(_side), base(0), n_window(0), lo(0), hi(0)
+{
+}
+
+// index of the first overflow level whose tick is not lower than t
+int PriceLadder::FarPosition(long long t) const
+{
+    int first = 0, count = static_cast<int>(far.size());
+    while (count > 0)
+    {
+        int step = count / 2;
+        if (far[first + step].tick < t)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+long long PriceLadder::MinTick() const
+{
+    long long t = far.size() ? far.front().tick : LLONG_MAX;
+    return n_window ? std::min(t, lo) : t;
+}
+
+long long PriceLadder::MaxTick() const
+{
+    long long t = far.size() ? far.back().tick : LLONG_MIN;
+    return n_window ? std::max(t, hi) : t;
+}
+
+double *PriceLadder::Find(long long t)
+{
+    return const_cast<double *>(static_cast<const PriceLadder *>(this)->Find(t));
+}
+
+const double *PriceLadder::Find(long long t) const
+{
+    if (InWindow(t))
+        return live[t - base] ? &vols[t - base] : nullptr;
+    int pos = FarPosition(t);
+    if (pos < static_cast<int>(far.size()) && far[pos].tick == t)
+        return &far[pos].volume;
+    return nullptr;
+}
+
+// re-lay the window over [new_base, new_base + new_size); levels outside go to the overflow
+void PriceLadder::Rebuild(long long new_base, long long new_size)
+{
+    std::vector<LadderLevel> levels;
+    Collect(levels);
+    base = new_base;
+    vols.assign(new_size, 0.0);
+    live.assign(new_size, 0);
+    n_window = 0;
+    far.resize(0);
+    for (auto &l : levels)
+    {
+        if (!InWindow(l.tick))
+        {
+            far.push_back(l);
+            continue;
+        }
+        vols[l.tick - base] = l.volume;
+        live[l.tick - base] = 1;
+        if (!n_window)
+            lo = l.tick;
+        hi = l.tick;
+        n_window++;
+    }
+}
+
+// move or grow the window so that it covers tick t; return false if t has to live in the overflow
+bool PriceLadder::Reframe(long long t)
+{
+    long long new_lo = n_window ? std::min(lo, t) : t;
+    long long new_hi = n_window ? std::max(hi, t) : t;
+    long long span = new_hi - new_lo + 1;
+    if (span <= MAX_WINDOW)
+    {
+        // grow around the occupied range with headroom on both ends
+        long long size = std::min(MAX_WINDOW, std::max(MIN_WINDOW, 2 * span));
+        Rebuild(new_lo - (size - span) / 2, size);
+        return true;
+    }
+    // the window cannot stretch that far: re-centre it only when t becomes the new touch,
+    // i.e. when the mid has drifted away from where the window was laid
+    if (side > 0 ? t < lo : t > hi)
+    {
+        Rebuild(t - MIN_WINDOW / 2, MIN_WINDOW);
+        return true;
+    }
+    return false;
+}
+
+// insert a new level at tick t, which must not exist yet
+void PriceLadder::Insert(long long t, double v)
+{
+    if (!InWindow(t) && !Reframe(t))
+    {
+        LadderLevel level = {t, v};
+        far.insert(far.begin() + FarPosition(t), level);
+        return;
+    }
+    vols[t - base] = v;
+    live[t - base] = 1;
+    lo = n_window ? std::min(lo, t) : t;
+    hi = n_window ? std::max(hi, t) : t;
+    n_window++;
+}
+
+void PriceLadder::Erase(long long t)
+{
+    if (!InWindow(t))
+    {
+        int pos = FarPosition(t);
+        if (pos < static_cast<int>(far.size()) && far[pos].tick == t)
+            far.erase(far.begin() + pos);
+        return;
+    }
+    if (!live[t - base])
+        return;
+    vols[t - base] = 0.0;
+    live[t - base] = 0;
+    if (!--n_window)
+        return;
+    // the best level moves by a short scan to the next occupied slot
+    while (!live[lo - base])
+        lo++;
+    while (!live[hi - base])
+        hi--;
+}
+
+// number of levels with tick lower than t
+int PriceLadder::CountBelow(long long t) const
+{
+    int count = FarPosition(t);
+    if (n_window)
+        for (long long i = lo; i <= std::min(hi, t - 1); i++)
+            count += live[i - base];
+    return count;
+}
+
+// level at position pos counted from the lowest tick
+LadderLevel PriceLadder::LevelAt(int pos) const
+{
+    int split = FarPosition(base);
+    if (pos < split)
+        return far[pos];
+    pos -= split;
+    if (pos < n_window)
+    {
+        for (long long t = lo; t <= hi; t++)
+        {
+            if (live[t - base] && !pos--)
+            {
+                LadderLevel level = {t, vols[t - base]};
+                return level;
+            }
+        }
+    }
+    return far[split + pos - n_window];
+}
+
+// copy all levels in ascending tick order
+void PriceLadder::Collect(std::vector<LadderLevel> &levels) const
+{
+    levels.resize(0);
+    levels.reserve(Size());
+    int split = FarPosition(base);
+    levels.insert(levels.end(), far.begin(), far.begin() + split);
+    if (n_window)
+    {
+        for (long long t = lo; t <= hi; t++)
+        {
+            if (!live[t - base])
+                continue;
+            LadderLevel level = {t, vols[t - base]};
+            levels.push_back(level);
+        }
+    }
+    levels.insert(levels.end(), far.begin() + split, far.end());
+}
+
+template <class SafetyPolicy>
+BasicLadderLOB<SafetyPolicy>::BasicLadderLOB()
+    : decay_coef(0.0),
+      bids(-1),
+      asks(1),
+      total_bids(0.0),
+      total_asks(0.0)
+{
+}
+
+template <class SafetyPolicy>
+BasicLadderLOB<SafetyPolicy>::BasicLadderLOB(const std::vector<double> &aps, const std::vector<double> &avs,
+                                             const std::vector<double> &bps, const std::vector<double> &bvs)
+    : BasicLadderLOB()
+{
+    if (aps.size() != avs.size() || bps.size() != bvs.size())
+        throw std::invalid_argument("Price and volume vectors must have same size");
+    for (int i = 0; i < 2; i++)
+    {
+        const std::vector<double> &ps = i == 0 ? aps : bps;
+        const std::vector<double> &vs = i == 0 ? avs : bvs;
+        PriceLadder &ladder = i == 0 ? asks : bids;
+        for (size_t j = 0; j < ps.size(); j++)
+        {
+            long long t = TickOf(ps[j]);
+            double *vol = ladder.Find(t);
+            if (vol)
+                *vol += vs[j];
+            else
+                ladder.Insert(t, vs[j]);
+        }
+    }
+    // summed in ascending prices as LOB does
+    for (int s = -1; s <= 1; s += 2)
+        Side(s).ForEach([&](long long, double v)
+                        { Total(s) += v; });
+}
+
+template <class SafetyPolicy>
+BasicLadderLOB<SafetyPolicy>::BasicLadderLOB(double _d_coef,
+                                             const std::vector<double> &aps, const std::vector<double> &avs,
+                                             const std::vector<double> &bps, const std::vector<double> &bvs)
+    : BasicLadderLOB(aps, avs, bps, bvs)
+{
+    decay_coef = _d_coef;
+    decay_table = DecayTable(decay_coef);
+}
+
+// convert a price to ticks, rejecting prices that saturate the tick range
+template <class SafetyPolicy>
+long long BasicLadderLOB<SafetyPolicy>::TickOf(double p) const
+{
+    long long t = Bar::PriceToTicks(p);
+    if (t == LLONG_MAX || t == LLONG_MIN)
+        throw std::invalid_argument("Price cannot be represented in ticks of the ladder.");
+    return t;
+}
+
+template <class SafetyPolicy>
+Bar BasicLadderLOB<SafetyPolicy>::Bid() const
+{
+    if (bids.Empty())
+        return theBidBar;
+    long long t = bids.MaxTick();
+    return Bar::FromTicks(t, *bids.Find(t));
+}
+
+template <class SafetyPolicy>
+Bar BasicLadderLOB<SafetyPolicy>::Ask() const
+{
+    if (asks.Empty())
+        return theAskBar;
+    long long t = asks.MinTick();
+    return Bar::FromTicks(t, *asks.Find(t));
+}
+
+// getter functions to obtain a specific bar in the lob
+template <class SafetyPolicy>
+Bar BasicLadderLOB<SafetyPolicy>::getBarAt(int s, int pos) const
+{
+    CheckUnsafeCall();
+    if (!s)
+        throw std::invalid_argument("Invalid sign; must be non-zero integer.");
+    const PriceLadder &ladder = Side(s);
+    int n_bars = ladder.Size();
+    if (pos >= n_bars || pos < -n_bars)
+        throw std::invalid_argument("Invalid bar position; out of boundary.");
+    LadderLevel level = ladder.LevelAt(pos >= 0 ? pos : n_bars + pos);
+    return Bar::FromTicks(level.tick, level.volume);
+}
+
+template <class SafetyPolicy>
+double BasicLadderLOB<SafetyPolicy>::getVolumeAt(int s, int pos) const
+{
+    return getBarAt(s, pos).Volume();
+}
+
+template <class SafetyPolicy>
+double BasicLadderLOB<SafetyPolicy>::getPriceAt(int s, int pos) const
+{
+    return getBarAt(s, pos).Price();
+}
+
+template <class SafetyPolicy>
+double BasicLadderLOB<SafetyPolicy>::getTotalVolume(int s) const
+{
+    if (s == 0)
+        return 0.0;
+    return s > 0 ? total_asks : total_bids;
+}
+
+// check whether the current LOB contains orders at price p; returns 1 (sell orders) or -1 (buy orders)
+template <class SafetyPolicy>
+int BasicLadderLOB<SafetyPolicy>::ContainsPrice(double p) const
+{
+    CheckUnsafeCall();
+    long long t = TickOf(p);
+    bool above_bid = bids.Empty() || bids.MaxTick() < t;
+    bool below_ask = asks.Empty() || asks.MinTick() > t;
+    if (above_bid && below_ask)
+        return 0;
+    const int sign = above_bid ? 1 : -1;
+    return Side(sign).Find(t) ? sign : 0;
+}
+
+// return the location of a price in one side of the lob (s = 1: asks; s = -1: bids), in ascending order
+template <class SafetyPolicy>
+int BasicLadderLOB<SafetyPolicy>::PriceLocation(int s, double p) const
+{
+    CheckUnsafeCall();
+    if (s == 0)
+        return -1;
+    return Side(s).CountBelow(TickOf(p));
+}
+
+// add a limit order of price p and volume v, with sign s (s = 1, an ask/sell order; s = -1, a bid/buy order)
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::AddLimitOrder(int s, double p, double v)
+{
+    CheckUnsafeCall();
+    if (s == 0)
+        return;
+    int state = ContainsPrice(p) * s; // 0 (insert new prices), 1 (increase vol in LOB), -1 (execute against existing bar)
+    long long t = TickOf(p);
+    if (state == 0)
+    {
+        Side(s).Insert(t, v);
+        Total(s) += v;
+    }
+    else if (state > 0)
+    {
+        *Side(s).Find(t) += v;
+        Total(s) += v;
+    }
+    else
+    {
+        // safety measure: make sure 2 sides never cross
+        if ((s > 0 && bids.MaxTick() > t) || (s < 0 && asks.MinTick() < t))
+            throw std::invalid_argument("Cannot post sell/buy limit order greater than bid/ask price!");
+
+        PriceLadder &ladder_other_side = Side(-s);
+        double &vol = *ladder_other_side.Find(t);
+        double executed_vol = std::min(vol, v);
+        vol -= executed_vol;
+        v -= executed_vol;
+        Total(-s) -= executed_vol;
+        if (std::abs(vol) < __DBL_EPSILON__)
+        {
+            Total(-s) -= vol;
+            ladder_other_side.Erase(t);
+            if (v > __DBL_EPSILON__) // if there is outstanding volume, we need to add it to existing lob
+                AddLimitOrder(s, p, v);
+        }
+    }
+}
+
+// cancel a limit order of price and and volume v
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::CancelLimitOrder(int s, double p, double v)
+{
+    CheckUnsafeCall();
+    int state = ContainsPrice(p);
+    if (s * state <= 0)
+        return;
+    long long t = TickOf(p);
+    double &vol = *Side(s).Find(t);
+    const double orig_vol = vol;
+    vol -= v;
+    if (vol < __DBL_EPSILON__)
+    {
+        Total(s) -= orig_vol;
+        Side(s).Erase(t);
+    }
+    else
+        Total(s) -= v;
+}
+
+// adjust the lob with an incoming market order of sign s (1: sell; -1: buy) and volume v
+// return how many orders are executed at what price, and VWAP as a double
+template <class SafetyPolicy>
+double BasicLadderLOB<SafetyPolicy>::AbsorbMarketOrder(std::vector<Bar> &eos,
+                                                       double &v,
+                                                       int s)
+{
+    CheckUnsafeCall();
+    if (s != -1 && s != 1)
+        throw std::invalid_argument("Invalid sign for market orders. Must be -1 or 1.");
+    eos.resize(0);
+    return Sweep(eos, v, s, s > 0 ? LLONG_MIN : LLONG_MAX);
+}
+
+// as LOB::StartOrder
+template <class SafetyPolicy>
+bool BasicLadderLOB<SafetyPolicy>::StartOrder(OrderType o_type, double p, int s, long long &t_limit) const
+{
+    CheckUnsafeCall();
+    if (s == 0)
+        return false;
+    switch (o_type)
+    {
+    case LIMITORDER:
+        t_limit = TickOf(p);
+        return true;
+    case MARKETORDER:
+        if (s != -1 && s != 1)
+            throw std::invalid_argument("Invalid sign for market orders. Must be -1 or 1.");
+        t_limit = s > 0 ? LLONG_MIN : LLONG_MAX;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// match an order of sign s against the best level of the other side up to t_limit, as LOB::FillBest
+template <class SafetyPolicy>
+bool BasicLadderLOB<SafetyPolicy>::FillBest(double &v, int s, long long t_limit, Bar &eo)
+{
+    int s_other_side = -s;
+    PriceLadder &ladder_other_side = Side(s_other_side);
+
+    while (ladder_other_side.Size())
+    {
+        long long t = ladder_other_side.Touch();
+        if (s > 0 ? t < t_limit : t > t_limit)
+            return false;
+        double &vol = *ladder_other_side.Find(t);
+        bool filled = false;
+        if (vol >= __DBL_EPSILON__)
+        {
+            if (v <= __DBL_EPSILON__)
+                return false;
+            double orig_v = v;
+            double executed_vol = std::min(vol, v);
+            vol -= executed_vol;
+            v -= executed_vol;
+            Total(s_other_side) -= executed_vol;
+            eo = Bar::FromTicks(t, s_other_side * (orig_v - v));
+            filled = true;
+        }
+        if (vol < __DBL_EPSILON__)
+        {
+            Total(s_other_side) -= vol;
+            ladder_other_side.Erase(t);
+        }
+        if (filled)
+            return true;
+    }
+    return false;
+}
+
+// match an order of sign s against the other side up to t_limit, as LOB::Sweep
+template <class SafetyPolicy>
+double BasicLadderLOB<SafetyPolicy>::Sweep(std::vector<Bar> &eos, double &v, int s, long long t_limit)
+{
+    double v_ttl = 0.0;
+    double pos_ttl = 0.0;
+    Bar eo;
+    while (FillBest(v, s, t_limit, eo))
+    {
+        double exe_v = std::abs(eo.Volume());
+        v_ttl += exe_v;
+        pos_ttl += exe_v * PriceOf(eo.Ticks());
+        eos.push_back(eo);
+    }
+    return std::abs(v_ttl) > __DBL_EPSILON__ ? pos_ttl / v_ttl : 0.0;
+}
+
+// pretty print the lob in the same format as LOB::PrintLOB
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::PrintLOB() const
+{
+    std::string title = " Current limit order book ";
+    std::string p_row = "price\t";
+    std::string v_row = "volume\t";
+    for (int s = -1; s <= 1; s += 2)
+    {
+        Side(s).ForEach([&](long long t, double v)
+                        {
+                            p_row += boost::str(boost::format("%1$.1f\t") % PriceOf(t));
+                            v_row += boost::str(boost::format("%1$.1f\t") % (s * v));
+                        });
+    }
+    int length = std::max(p_row.length(), v_row.length());
+    int nchar1 = std::max(int(length - title.size()) / 2, 0);
+    int nchar2 = std::max(int(length - nchar1 - title.size()), 0);
+    title = std::string(nchar1, '=') + title + std::string(nchar2, '=');
+    std::cout << title << std::endl;
+    std::cout << p_row << std::endl;
+    std::cout << v_row << std::endl;
+}
+
+// decay resting orders in current LOB with a decay coefficient
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::DecayOrders(double d_coef)
+{
+    CheckUnsafeCall();
+    const double p_mid = mid();
+    const bool use_table = decay_table.Covers(d_coef) && !oneSideEmpty();
+    const long long mid2 = use_table ? bids.MaxTick() + asks.MinTick() : 0;
+    // totals are recounted in the same pass
+    double volume = 0.0;
+    auto decay = [&](long long t, double &v)
+    {
+        double d_factor = use_table ? decay_table.Factor(2 * t - mid2) : DecayKernel::Factor(p_mid, PriceOf(t), d_coef);
+        // v = v * a = v + (a - 1) * v
+        v += (d_factor - 1) * v;
+        volume += v;
+    };
+    asks.ForEach(decay);
+    total_asks = volume;
+    volume = 0.0;
+    bids.ForEach(decay);
+    total_bids = volume;
+}
+
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::DecayOrders()
+{
+    DecayOrders(decay_coef);
+}
+
+// update LOB and add order based on order type
+// return exercised limit order, sell/buy direction is marked by the sign of bar.volume
+template <class SafetyPolicy>
+std::vector<Bar> BasicLadderLOB<SafetyPolicy>::AbsorbGeneralOrder(OrderType o_type, double p, double v, int s)
+{
+    std::vector<Bar> executed_orders;
+    AbsorbGeneralOrder(executed_orders, o_type, p, v, s);
+    return executed_orders;
+}
+
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::AbsorbGeneralOrder(std::vector<Bar> &eos, OrderType o_type, double p, double v, int s)
+{
+    CheckUnsafeCall();
+    eos.resize(0);
+    if (s == 0)
+        return;
+    switch (o_type)
+    {
+    case LIMITORDER:
+    {
+        AbsorbLimitOrder(eos, v, p, s);
+        break;
+    }
+    case MARKETORDER:
+    {
+        AbsorbMarketOrder(eos, v, s);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::AbsorbLimitOrder(std::vector<Bar> &eos,
+                                                    double &v,
+                                                    double p,
+                                                    int s)
+{
+    CheckUnsafeCall();
+    if (s == 0)
+        return;
+    eos.resize(0);
+    // an illegal LO, one that crosses the other side, executes against it up to its price first
+    long long t = TickOf(p);
+    Sweep(eos, v, s, t);
+    Rest(v, t, s);
+}
+
+// rest the outstanding volume v of a limit order of sign s at tick t, as LOB::Rest
+template <class SafetyPolicy>
+void BasicLadderLOB<SafetyPolicy>::Rest(double v, long long t, int s)
+{
+    if (v > __DBL_EPSILON__)
+    {
+        double *vol = Side(s).Find(t);
+        if (vol)
+            *vol += v;
+        else
+            Side(s).Insert(t, v);
+        Total(s) += v;
+    }
+}
+
+template <class SafetyPolicy>
+int BasicLadderLOB<SafetyPolicy>::AbsorbOrders(const Order *orders, int n,
+                                               std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+{
+    for (int i = 0; i < n; i++)
+    {
+        DecayOrders();
+        if (!AbsorbTick(orders[i], mids, eos, eo_ends))
+            return i + 1;
+    }
+    return n;
+}
+
+// absorb one order of a batch, appending its executions straight to eos, and record the resulting mid
+// unless the order left a side empty
+template <class SafetyPolicy>
+bool BasicLadderLOB<SafetyPolicy>::AbsorbTick(const Order &o, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+{
+    AbsorbGeneralOrder([&eos](const Bar &eo)
+                       { eos.push_back(eo); },
+                       o.type, o.p, o.v, o.s);
+    eo_ends.push_back(static_cast<int>(eos.size()));
+    if (oneSideEmpty())
+    {
+        CheckUnsafeCall();
+        return false;
+    }
+    mids.push_back(mid());
+    return true;
+}
+
+template class BasicLadderLOB<UncheckedCalls>;
+template class BasicLadderLOB<CheckedCalls>;
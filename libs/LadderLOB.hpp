@@ -0,0 +1,211 @@
+#ifndef microhedger_utilities_ladder_lob_hpp
+#define microhedger_utilities_ladder_lob_hpp
+
+#include <vector>
+#include <stdexcept>
+#include "Bar.hpp"
+#include "Utils.hpp"
+#include "DecayKernel.hpp"
+#include "SafetyPolicy.hpp"
+
+struct LadderLevel
+{
+    long long tick; // price in number of ticks
+    double volume;
+};
+
+// one side of the book, stored as a dense window of slots indexed by tick offset;
+// levels too far away from the touch to share the window are kept in a sorted overflow
+class PriceLadder
+{
+private:
+    int side;                  // 1: asks, touch is the lowest tick; -1: bids, touch is the highest tick
+    long long base;            // tick of the first slot in the window
+    std::vector<double> vols;  // volume of each slot
+    std::vector<char> live;    // whether a slot holds a level (dummy bars may have zero volume)
+    int n_window;              // number of levels inside the window
+    long long lo, hi;          // lowest and highest occupied tick inside the window
+    std::vector<LadderLevel> far; // levels outside the window with ascending ticks
+    KeyHolder keys;               // keeps the tick size from changing under prices stored without one
+
+    inline bool InWindow(long long t) const { return t >= base && t - base < (long long)vols.size(); }
+    int FarPosition(long long t) const;
+    void Rebuild(long long new_base, long long new_size);
+    bool Reframe(long long t);
+
+public:
+    static const long long MIN_WINDOW = 64;
+    static const long long MAX_WINDOW = 4096;
+
+    PriceLadder(int _side = 1);
+    ~PriceLadder() {}
+
+    inline int Size() const { return n_window + static_cast<int>(far.size()); }
+    inline bool Empty() const { return !Size(); }
+
+    long long MinTick() const;
+    long long MaxTick() const;
+    inline long long Touch() const { return side > 0 ? MinTick() : MaxTick(); }
+
+    double *Find(long long t);
+    const double *Find(long long t) const;
+    void Insert(long long t, double v);
+    void Erase(long long t);
+
+    int CountBelow(long long t) const;
+    LadderLevel LevelAt(int pos) const;
+    void Collect(std::vector<LadderLevel> &levels) const;
+
+    // visit every level in ascending tick order as f(tick, volume)
+    template <class F>
+    void ForEach(F f)
+    {
+        int split = FarPosition(base);
+        for (int i = 0; i < split; i++)
+            f(far[i].tick, far[i].volume);
+        if (n_window)
+            for (long long t = lo; t <= hi; t++)
+                if (live[t - base])
+                    f(t, vols[t - base]);
+        for (int i = split; i < static_cast<int>(far.size()); i++)
+            f(far[i].tick, far[i].volume);
+    }
+
+    template <class F>
+    void ForEach(F f) const
+    {
+        int split = FarPosition(base);
+        for (int i = 0; i < split; i++)
+            f(far[i].tick, far[i].volume);
+        if (n_window)
+            for (long long t = lo; t <= hi; t++)
+                if (live[t - base])
+                    f(t, vols[t - base]);
+        for (int i = split; i < static_cast<int>(far.size()); i++)
+            f(far[i].tick, far[i].volume);
+    }
+};
+
+// limit order book with the core interface of LOB, backed by tick-indexed price ladders
+// so that lookups, inserts and cancels are O(1) and moving the touch is a short scan.
+// paths run on it through LadderPathCollection. it leaves out what LOB has grown since: lazy decay,
+// depth profiles, order queues and handles, pruning, VWAP and volume queries, and snapshots that
+// share storage, as copying a ladder copies every level. it needs a tick size to be of use: without
+// one, levels are far apart in ticks and live in the sorted overflow, where inserts are O(n)
+template <class SafetyPolicy>
+class BasicLadderLOB
+{
+private:
+    double decay_coef;
+    PriceLadder bids; // all the buy orders
+    PriceLadder asks; // all the sell orders
+    DecayTable decay_table; // cached factors for decay_coef
+    double total_bids;      // running total volume of each side, as in LOB
+    double total_asks;
+
+    long long TickOf(double p) const;
+    inline double PriceOf(long long t) const { return Bar::TicksToPrice(t); }
+    inline PriceLadder &Side(int s) { return s > 0 ? asks : bids; }
+    inline const PriceLadder &Side(int s) const { return s > 0 ? asks : bids; }
+    inline double &Total(int s) { return s > 0 ? total_asks : total_bids; }
+    bool StartOrder(OrderType o_type, double p, int s, long long &t_limit) const;
+    bool FillBest(double &v, int s, long long t_limit, Bar &eo);
+    double Sweep(std::vector<Bar> &eos, double &v, int s, long long t_limit);
+    void Rest(double v, long long t, int s);
+    bool AbsorbTick(const Order &o, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends);
+
+public:
+    BasicLadderLOB();
+    BasicLadderLOB(const std::vector<double> &aps, const std::vector<double> &avs,
+                   const std::vector<double> &bps, const std::vector<double> &bvs);
+    BasicLadderLOB(double _d_coef,
+                   const std::vector<double> &aps, const std::vector<double> &avs,
+                   const std::vector<double> &bps, const std::vector<double> &bvs);
+    ~BasicLadderLOB() {}
+
+    inline double bid() const { return bids.Size() ? PriceOf(bids.MaxTick()) : -__DBL_MAX__; }
+    inline double ask() const { return asks.Size() ? PriceOf(asks.MinTick()) : __DBL_MAX__; }
+    inline double mid() const { return (ask() + bid()) * 0.5; }
+    Bar Bid() const;
+    Bar Ask() const;
+    inline bool oneSideEmpty() const { return asks.Empty() || bids.Empty(); }
+    inline bool bothSidesEmpty() const { return asks.Empty() && bids.Empty(); }
+
+    Bar getBarAt(int s, int pos) const;
+    double getVolumeAt(int s, int pos) const;
+    double getPriceAt(int s, int pos) const;
+
+    double getTotalVolume(int s) const;
+    inline int getNumLevels(int s) const { return s ? Side(s).Size() : 0; }
+
+    int ContainsPrice(double p) const;
+    int PriceLocation(int s, double p) const;
+    inline void CheckUnsafeCall() const
+    {
+        if (SafetyPolicy::ENABLED && oneSideEmpty())
+            throw std::out_of_range("One side of the LOB is empty. Potential malfunction under market failure.");
+    }
+    void PrintLOB() const;
+
+    void AddLimitOrder(int s, double p, double v);
+    void CancelLimitOrder(int s, double p, double v);
+    double AbsorbMarketOrder(std::vector<Bar> &eos, // [O] - executed orders
+                             double &v,             // [I] and [O] - input volume and outstanding volume
+                             int s);                // [I] - sign of the market order
+    void AbsorbLimitOrder(std::vector<Bar> &eos,
+                          double &v,
+                          double p,
+                          int s);
+    void DecayOrders(double d_coef);
+    void DecayOrders();
+    std::vector<Bar> AbsorbGeneralOrder(OrderType o_type, // [I] - order type
+                                        double p,         // [I] - price of order
+                                        double v,         // [I] - volume of order
+                                        int s             // [I] - sign of order
+    );
+    // as above, but writes into a buffer owned by the caller, so that reusing it allocates nothing
+    void AbsorbGeneralOrder(std::vector<Bar> &eos, // [O] - executed orders, cleared first
+                            OrderType o_type,      // [I] - order type
+                            double p,              // [I] - price of order
+                            double v,              // [I] - volume of order
+                            int s                  // [I] - sign of order
+    );
+    // as above, but hands each executed order to sink(const Bar &) as it is matched instead of storing it
+    template <class Sink>
+    void AbsorbGeneralOrder(Sink &&sink, OrderType o_type, double p, double v, int s)
+    {
+        long long t_limit;
+        if (!StartOrder(o_type, p, s, t_limit))
+            return;
+        Bar eo;
+        while (FillBest(v, s, t_limit, eo))
+            sink(eo);
+        if (o_type == LIMITORDER)
+            Rest(v, t_limit, s);
+    }
+
+    // apply a run of orders, each after a round of decay, as LOB::AbsorbOrders
+    int AbsorbOrders(const Order *orders, int n,
+                     std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends);
+    // as above, with each order drawn by gen(Order &, double p_mid), as LOB::AbsorbOrderFlow
+    template <class Gen>
+    int AbsorbOrderFlow(Gen &&gen, int n, std::vector<double> &mids, std::vector<Bar> &eos, std::vector<int> &eo_ends)
+    {
+        if (!SafetyPolicy::ENABLED && oneSideEmpty())
+            return 0;
+        for (int i = 0; i < n; i++)
+        {
+            DecayOrders();
+            Order o = {MARKETORDER, 0.0, 0.0, 0};
+            gen(o, mid());
+            if (!AbsorbTick(o, mids, eos, eo_ends))
+                return i + 1;
+        }
+        return n;
+    }
+};
+
+typedef BasicLadderLOB<UncheckedCalls> LadderLOB;
+typedef BasicLadderLOB<CheckedCalls> CheckedLadderLOB;
+
+#endif
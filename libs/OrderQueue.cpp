@@ -0,0 +1,369 @@
+#include <algorithm>
+#include "OrderQueue.hpp"
+
+// give a new order of u units the next slot; the new node of the tree sums the nodes it covers
+int LevelQueue::Push(double u)
+{
+    const int n = static_cast<int>(tree.size()) + 1;
+    double sum = u;
+    for (int j = 1; j < (n & -n); j <<= 1)
+        sum += tree[n - j - 1];
+    tree.push_back(sum);
+    return n - 1;
+}
+
+void LevelQueue::Add(int slot, double du)
+{
+    const int n = tree.size();
+    for (int i = slot + 1; i <= n; i += i & -i)
+        tree[i - 1] += du;
+}
+
+// units in the slots ahead of slot
+double LevelQueue::Before(int slot) const
+{
+    double sum = 0.0;
+    for (int i = slot; i > 0; i -= i & -i)
+        sum += tree[i - 1];
+    return sum;
+}
+
+// double the table and put every level back, at least 16 slots so that small sides never grow
+void TickTable::Grow()
+{
+    std::vector<long long> old_ticks;
+    std::vector<int> old_levels;
+    old_ticks.swap(ticks);
+    old_levels.swap(levels);
+    const int size = std::max<int>(16, 2 * old_levels.size());
+    ticks.assign(size, 0);
+    levels.assign(size, -1);
+    for (size_t i = 0; i < old_levels.size(); i++)
+        if (old_levels[i] >= 0)
+        {
+            int j = Home(old_ticks[i]);
+            while (levels[j] >= 0)
+                j = (j + 1) & (size - 1);
+            ticks[j] = old_ticks[i];
+            levels[j] = old_levels[i];
+        }
+}
+
+// level of tick t, or -1 if it has none
+int TickTable::Find(long long t) const
+{
+    if (levels.empty())
+        return -1;
+    const int mask = levels.size() - 1;
+    for (int i = Home(t); levels[i] >= 0; i = (i + 1) & mask)
+        if (ticks[i] == t)
+            return levels[i];
+    return -1;
+}
+
+// add a tick that has no level yet, keeping the table at most half full
+void TickTable::Insert(long long t, int level)
+{
+    if (2 * (count + 1) > static_cast<int>(levels.size()))
+        Grow();
+    const int mask = levels.size() - 1;
+    int i = Home(t);
+    while (levels[i] >= 0)
+        i = (i + 1) & mask;
+    ticks[i] = t;
+    levels[i] = level;
+    count++;
+}
+
+// remove a tick, moving back the entries after it that would otherwise no longer be found
+void TickTable::Erase(long long t)
+{
+    if (levels.empty())
+        return;
+    const int mask = levels.size() - 1;
+    int i = Home(t);
+    while (levels[i] >= 0 && ticks[i] != t)
+        i = (i + 1) & mask;
+    if (levels[i] < 0)
+        return;
+    levels[i] = -1;
+    count--;
+    for (int j = (i + 1) & mask; levels[j] >= 0; j = (j + 1) & mask)
+    {
+        // the entry at j may fill the hole at i unless its home lies cyclically in (i, j]
+        const int k = Home(ticks[j]);
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        ticks[i] = ticks[j];
+        levels[i] = levels[j];
+        levels[j] = -1;
+        i = j;
+    }
+}
+
+OrderQueues::OrderQueues(int capacity)
+    : free_head(-1), free_level(-1)
+{
+    Reserve(capacity);
+}
+
+// set aside room for capacity orders, so that posting up to that many allocates nothing
+void OrderQueues::Reserve(int capacity)
+{
+    if (capacity > 0)
+        nodes.reserve(capacity);
+}
+
+const OrderNode *OrderQueues::Find(const OrderHandle &h) const
+{
+    if (h.node < 0 || h.node >= static_cast<int>(nodes.size()))
+        return nullptr;
+    const OrderNode &node = nodes[h.node];
+    return node.live && node.gen == h.gen ? &node : nullptr;
+}
+
+// a node from the free list, or a new one at the end of the pool
+int OrderQueues::Allocate()
+{
+    if (free_head >= 0)
+    {
+        int i = free_head;
+        free_head = nodes[i].next;
+        return i;
+    }
+    nodes.push_back(OrderNode{0.0, 0, 0, -1, -1, -1, -1, 0, false});
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+// an empty queue for tick t of side s, recycled from the pool when one is free
+int OrderQueues::NewLevel(int s, long long t)
+{
+    int l = free_level;
+    if (l >= 0)
+        free_level = levels[l].next_free;
+    else
+    {
+        levels.push_back(LevelQueue());
+        l = static_cast<int>(levels.size()) - 1;
+    }
+    LevelQueue &q = levels[l];
+    q.head = q.tail = -1;
+    q.length = 0;
+    q.units = 0.0;
+    q.tree.clear();
+    Levels(s).Insert(t, l);
+    return l;
+}
+
+void OrderQueues::FreeLevel(int s, long long t, int l)
+{
+    Levels(s).Erase(t);
+    levels[l].next_free = free_level;
+    free_level = l;
+}
+
+// give the live orders of a queue the first slots, in their order, and rebuild its tree over them
+void OrderQueues::Compact(LevelQueue &q)
+{
+    q.tree.assign(q.length, 0.0);
+    int k = 0;
+    for (int i = q.head; i >= 0; i = nodes[i].next, k++)
+    {
+        nodes[i].slot = k;
+        q.tree[k] = nodes[i].units;
+    }
+    const int n = q.length;
+    for (int i = 1; i <= n; i++)
+    {
+        const int parent = i + (i & -i);
+        if (parent <= n)
+            q.tree[parent - 1] += q.tree[i - 1];
+    }
+}
+
+void OrderQueues::Unlink(LevelQueue &q, int i)
+{
+    OrderNode &node = nodes[i];
+    if (node.prev >= 0)
+        nodes[node.prev].next = node.next;
+    else
+        q.head = node.next;
+    if (node.next >= 0)
+        nodes[node.next].prev = node.prev;
+    else
+        q.tail = node.prev;
+    q.Add(node.slot, -node.units);
+    q.units -= node.units;
+    q.length--;
+}
+
+void OrderQueues::Free(int i)
+{
+    OrderNode &node = nodes[i];
+    node.live = false;
+    node.gen++;
+    node.next = free_head;
+    free_head = i;
+}
+
+// link a new node of the given units at the back of queue l, compacting the queue first once
+// departed orders fill most of its slots, which keeps the rebuilds at O(1) per order
+int OrderQueues::Append(int l, int s, long long t, double units)
+{
+    int i = Allocate();
+    LevelQueue &q = levels[l];
+    if (static_cast<int>(q.tree.size()) >= 2 * q.length + 16)
+        Compact(q);
+    OrderNode &node = nodes[i];
+    node.units = units;
+    node.tick = t;
+    node.side = s;
+    node.level = l;
+    node.slot = q.Push(units);
+    node.prev = q.tail;
+    node.next = -1;
+    node.live = true;
+    if (q.tail >= 0)
+        nodes[q.tail].next = i;
+    else
+        q.head = i;
+    q.tail = i;
+    q.units += units;
+    q.length++;
+    return i;
+}
+
+// append an order of volume v at the back of the queue at tick t of side s
+OrderHandle OrderQueues::Push(int s, long long t, double v, double v_level)
+{
+    // a level the book has just created starts a fresh queue
+    if (v_level <= 0.0)
+        Clear(s, t);
+    int l = Levels(s).Find(t);
+    if (l < 0)
+        l = NewLevel(s, t);
+    // volume that was at the level before it was queued stands ahead as one order
+    if (levels[l].head < 0 && v_level > 0.0)
+        Append(l, s, t, v_level);
+    const double q_units = levels[l].units;
+    const double units = q_units > 0.0 ? v * q_units / v_level : v;
+    OrderHandle h;
+    h.node = Append(l, s, t, units);
+    h.gen = nodes[h.node].gen;
+    return h;
+}
+
+// remove volume v from the front (executions) or the back (anonymous cancels) of a queue
+double OrderQueues::Take(int s, long long t, double v, double v_level, bool from_head)
+{
+    const int l = Levels(s).Find(t);
+    if (l < 0)
+        return 0.0;
+    LevelQueue &q = levels[l];
+    if (v >= v_level)
+    {
+        Clear(s, t);
+        return v_level;
+    }
+    double units = v * q.units / v_level;
+    while (units > 0.0 && q.head >= 0)
+    {
+        const int i = from_head ? q.head : q.tail;
+        OrderNode &node = nodes[i];
+        if (node.units > units)
+        {
+            node.units -= units;
+            q.units -= units;
+            q.Add(node.slot, -units);
+            break;
+        }
+        units -= node.units;
+        Unlink(q, i);
+        Free(i);
+    }
+    if (q.head < 0)
+        FreeLevel(s, t, l);
+    return v;
+}
+
+// execute volume v against the orders at the front of the queue
+void OrderQueues::Consume(int s, long long t, double v, double v_level)
+{
+    Take(s, t, v, v_level, true);
+}
+
+// cancel volume v of unidentified orders, taken from the back of the queue where the newest orders are
+void OrderQueues::Trim(int s, long long t, double v, double v_level)
+{
+    Take(s, t, v, v_level, false);
+}
+
+// drop the queue of a level that has left the book
+void OrderQueues::Clear(int s, long long t)
+{
+    const int l = Levels(s).Find(t);
+    if (l < 0)
+        return;
+    for (int i = levels[l].head; i >= 0;)
+    {
+        int next = nodes[i].next;
+        Free(i);
+        i = next;
+    }
+    FreeLevel(s, t, l);
+}
+
+// take an order out of its queue; return its volume, or 0 if it has already been filled or cancelled
+double OrderQueues::Remove(const OrderHandle &h, double v_level)
+{
+    const OrderNode *node = Find(h);
+    if (!node)
+        return 0.0;
+    const int s = node->side;
+    const long long t = node->tick;
+    const int l = node->level;
+    LevelQueue &q = levels[l];
+    const double v = node->units >= q.units ? v_level : node->units * v_level / q.units;
+    Unlink(q, h.node);
+    Free(h.node);
+    if (q.head < 0)
+        FreeLevel(s, t, l);
+    return v;
+}
+
+// side and tick of a live order
+bool OrderQueues::Locate(const OrderHandle &h, int &s, long long &t) const
+{
+    const OrderNode *node = Find(h);
+    if (!node)
+        return false;
+    s = node->side;
+    t = node->tick;
+    return true;
+}
+
+// fraction of its level's volume that a live order holds; 0 once it is gone
+double OrderQueues::Share(const OrderHandle &h) const
+{
+    const OrderNode *node = Find(h);
+    if (!node)
+        return 0.0;
+    const LevelQueue &q = levels[node->level];
+    return std::min(node->units / q.units, 1.0);
+}
+
+// fraction of its level's volume queued ahead of a live order
+double OrderQueues::ShareAhead(const OrderHandle &h) const
+{
+    const OrderNode *node = Find(h);
+    if (!node)
+        return 0.0;
+    const LevelQueue &q = levels[node->level];
+    return std::min(std::max(q.Before(node->slot), 0.0) / q.units, 1.0);
+}
+
+int OrderQueues::QueueLength(int s, long long t) const
+{
+    const int l = Levels(s).Find(t);
+    return l < 0 ? 0 : levels[l].length;
+}
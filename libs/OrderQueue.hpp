@@ -0,0 +1,118 @@
+#ifndef microhedger_utilities_order_queue_hpp
+#define microhedger_utilities_order_queue_hpp
+
+#include <vector>
+
+// handle to an individual order resting in an OrderQueues; stays safe to use after the order is gone
+struct OrderHandle
+{
+    int node = -1;     // index of the order in the node pool
+    unsigned gen = 0;  // generation of that node when the order was posted
+
+    inline bool IsValid() const { return node >= 0; }
+};
+
+// an individual order, linked into the queue of its price level or into the free list
+struct OrderNode
+{
+    double units;     // size of the order in units of its level, see OrderQueues
+    long long tick;
+    int side;
+    int level;        // index of its level in the level pool
+    int slot;         // position of the order in the tree of its level, see LevelQueue
+    int prev;
+    int next;
+    unsigned gen;     // bumped each time the node is freed
+    bool live;
+};
+
+// FIFO queue of the orders at one price level. every order takes the next slot of a Fenwick tree of
+// units, so that the units ahead of it are a prefix sum. the slots of departed orders hold 0 until the
+// tree is rebuilt over the live orders, once those are outnumbered
+struct LevelQueue
+{
+    int head;
+    int tail;
+    int length;               // number of orders in the queue
+    double units;             // sum over the orders in the queue
+    std::vector<double> tree; // Fenwick tree over slots, kept when the level is recycled
+    int next_free;            // next level in the free list of the pool
+
+    int Push(double u);
+    void Add(int slot, double du);
+    double Before(int slot) const;
+};
+
+// open-addressed table from the ticks of one side to their levels in the pool, which allocates
+// nothing once it has held as many levels as the side has
+class TickTable
+{
+private:
+    std::vector<long long> ticks;
+    std::vector<int> levels; // -1 for an empty slot
+    int count;
+
+    inline int Home(long long t) const
+    {
+        unsigned long long h = static_cast<unsigned long long>(t) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<int>((h ^ (h >> 32)) & (levels.size() - 1));
+    }
+    void Grow();
+
+public:
+    TickTable() : count(0) {}
+
+    int Find(long long t) const;
+    void Insert(long long t, int level);
+    void Erase(long long t);
+};
+
+// level-3 view of a book: the volume of every price level split into a FIFO queue of individual
+// orders. the book's aggregate volume of a level stays authoritative and an order holds a share
+// of it, units / sum of units in the queue, so decay, which scales a whole level, needs no work here.
+// callers pass the level's volume v_level before each change. orders and levels live in pools that
+// are recycled, orders are reached through handles in O(1), and with n orders at a level, posting,
+// cancelling by handle and the position of an order take O(log n), as does each order that an
+// execution or an anonymous cancel takes out; the queue length is O(1)
+class OrderQueues
+{
+private:
+    std::vector<OrderNode> nodes;
+    int free_head;
+    std::vector<LevelQueue> levels;
+    int free_level;
+    TickTable bid_levels;
+    TickTable ask_levels;
+
+    inline TickTable &Levels(int s) { return s > 0 ? ask_levels : bid_levels; }
+    inline const TickTable &Levels(int s) const { return s > 0 ? ask_levels : bid_levels; }
+    const OrderNode *Find(const OrderHandle &h) const;
+    int Allocate();
+    int NewLevel(int s, long long t);
+    void FreeLevel(int s, long long t, int l);
+    void Compact(LevelQueue &q);
+    int Append(int l, int s, long long t, double units);
+    void Unlink(LevelQueue &q, int i);
+    void Free(int i);
+    double Take(int s, long long t, double v, double v_level, bool from_head);
+
+public:
+    OrderQueues(int capacity = 0);
+    ~OrderQueues() {}
+
+    void Reserve(int capacity);
+    inline int Capacity() const { return static_cast<int>(nodes.capacity()); }
+
+    OrderHandle Push(int s, long long t, double v, double v_level);
+    void Consume(int s, long long t, double v, double v_level);
+    void Trim(int s, long long t, double v, double v_level);
+    void Clear(int s, long long t);
+    double Remove(const OrderHandle &h, double v_level);
+
+    bool Locate(const OrderHandle &h, int &s, long long &t) const;
+    double Share(const OrderHandle &h) const;
+    double ShareAhead(const OrderHandle &h) const;
+    int QueueLength(int s, long long t) const;
+};
+
+#endif
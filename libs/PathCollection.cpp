@@ -3,16 +3,17 @@
 #include "PathCollection.hpp"
 #include <boost/format.hpp>
 
-void PathInfo::GenerateScenarios(std::vector<PathInfo> &scens,
-                                 const Parameter &param_name,
-                                 const std::vector<double> &range,
-                                 const PathInfo &pi_template)
+template <class Book>
+void BasicPathInfo<Book>::GenerateScenarios(std::vector<BasicPathInfo> &scens,
+                                            const Parameter &param_name,
+                                            const std::vector<double> &range,
+                                            const BasicPathInfo &pi_template)
 {
     const int n = range.size();
     scens.resize(n, pi_template);
     for (int i = 0; i < n; i++)
     {
-        PathInfo &scen = scens[i];
+        BasicPathInfo &scen = scens[i];
         double val = range[i];
         switch (param_name)
         {
@@ -41,8 +42,9 @@ void PathInfo::GenerateScenarios(std::vector<PathInfo> &scens,
     }
 }
 
-Path::Path(
-    const PathInfo &_path_info,
+template <class Book>
+BasicPath<Book>::BasicPath(
+    const BasicPathInfo<Book> &_path_info,
     const RandomInfo &_ran_info)
     : n_days(_path_info.n_days),
       n_hours(_path_info.n_hours),
@@ -51,20 +53,20 @@ Path::Path(
       ran_info(_ran_info)
 {
     status = 0;
-    LOB lob_0(_path_info.lob_0);
-    lob_0.setSafetyCheck(true); // activate safety check for recording liquidity crisis
-    lobs.resize(1, lob_0);
+    lobs.resize(1, _path_info.lob_0);
     mid_prices.resize(1, _path_info.lob_0.mid());
     hedger_deltas.resize(1, 0.0);
     hedger_gammas.resize(1, 0.0);
     fund_prices.resize(1, _path_info.p_0);
 }
 
-Path::~Path()
+template <class Book>
+BasicPath<Book>::~BasicPath()
 {
 }
 
-void Path::ClearPath()
+template <class Book>
+void BasicPath<Book>::ClearPath()
 {
     hedger.ClearOrderAndInventories();
     lobs.resize(0);
@@ -73,96 +75,114 @@ void Path::ClearPath()
     fund_prices.resize(0);
 }
 
-void Path::GenOnePath()
+template <class Book>
+void BasicPath<Book>::GenOnePath()
 {
     Random rd(ran_info);
-    try
+    // the executed orders of a quarter as one log, with the end of each tick's executions;
+    // buffers are reused across quarters so that recording them stops allocating once they have grown
+    std::vector<std::vector<Bar>> exe_orders(1);
+    std::vector<int> exe_ends;
+    std::vector<std::vector<Bar>> exe_order_hedger(1);
+    // numbers of orders of an hour and orders of a quarter drawn up front when asked for,
+    // into buffers reused across quarters
+    const bool batch = ran_info.batch_draws;
+    OrderDraws draws;
+    std::vector<int> n_orders;
+    for (int day = 0; day < n_days; day++)
     {
-        for (int day = 0; day < n_days; day++)
+        double time = day;
+        hedger.ResetGammaContract(time, lobs.back());
+        for (int hour = 0; hour < n_hours; hour++)
         {
-            double time = day;
-            hedger.ResetGammaContract(time, lobs.back());
-            for (int hour = 0; hour < n_hours; hour++)
+            // news arrives and fundamental price changes
+            const double ph = rd.GenerateShockedPrice(fund_prices.back());
+            if (batch)
+                rd.GenerateNumOrders(n_quarters, n_orders);
+            for (int quar = 0; quar < n_quarters; quar++)
             {
-                // news arrives and fundamental price changes
-                const double ph = rd.GenerateShockedPrice(fund_prices.back());
-                for (int quar = 0; quar < n_quarters; quar++)
-                {
-                    // create a copy of current LOB
-                    LOB currLOB(lobs.back());
-                    const int n_ticks = rd.GenerateNumOrders();
-                    std::vector<std::vector<Bar>> exe_orders;
-                    for (int tick = 0; tick < n_ticks; tick++)
-                    {
-                        currLOB.DecayOrders();
-                        double p = 0.0, v = 0.0;
-                        int s = 0; // sell: 1, buy: -1
-                        enum OrderType order_type;
-                        rd.GenerateOrder(order_type, p, v, s, currLOB.mid(), ph); // generate a new order
-                        // update LOB to include the order and report what orders are exercised
-                        std::vector<Bar> exe_order = currLOB.AbsorbGeneralOrder(order_type, p, v, s);
-                        exe_orders.push_back(exe_order);
-                        mid_prices.push_back(currLOB.mid());
-                    }
-
-                    // based on execution results of this quarter hedger knows his state
-                    if (!hedger.IsMyOrderExecuted(exe_orders))
-                    {
-                        // he either removes posted but unexecuted order (if any)
-                        currLOB.CancelLimitOrder(Utils::sgn(hedger.getOrderVolume()), hedger.getOrderPrice(), abs(hedger.getOrderVolume()));
-                        // and submit new order based on current LOB
-                        double p_hedger = 0.0, v_hedger = 0.0, t_q = (double)quar / n_quarters;
-                        int s_hedger = 0;
-                        hedger.PostOrder(p_hedger, v_hedger, s_hedger, exe_orders, currLOB, t_q);
-                        // LOB absorb hedger's order
-                        std::vector<Bar> exe_order_hedger = currLOB.AbsorbGeneralOrder(LIMITORDER, p_hedger, v_hedger, s_hedger);
-                        // hedger updates inventories
-                        hedger.UpdateInventories(std::vector<std::vector<Bar>>(1, exe_order_hedger));
-                    }
-                    else
-                    {
-                        // or he updates his inventories
-                        hedger.UpdateInventories(exe_orders);
-                    }
+                // create a copy of current LOB; LOB clones level chunks only when first writing to them
+                Book currLOB(lobs.back());
+                const int n_ticks = batch ? n_orders[quar] : rd.GenerateNumOrders();
+                exe_orders[0].resize(0);
+                exe_ends.resize(0);
+                if (batch)
+                    rd.GenerateOrders(n_ticks, draws);
+                int i_tick = 0;
+                // each tick decays the book, draws a new order around its mid and absorbs it;
+                // the flow stops at the order that leaves a side of the book empty, before its mid is recorded
+                currLOB.AbsorbOrderFlow([&rd, &draws, &i_tick, batch, ph](Order &o, double p_mid)
+                                        {
+                                            if (batch)
+                                                draws.Order(i_tick++, o.type, o.p, o.v, o.s, p_mid, ph);
+                                            else
+                                                rd.GenerateOrder(o.type, o.p, o.v, o.s, p_mid, ph);
+                                        },
+                                        n_ticks, mid_prices, exe_orders[0], exe_ends);
+                if (MarketFailed(currLOB))
+                    return;
 
-                    // record latest fundamental prices and lob
-                    fund_prices.push_back(ph);
-                    lobs.push_back(currLOB);
+                // based on execution results of this quarter hedger knows his state
+                if (!hedger.IsMyOrderExecuted(exe_orders))
+                {
+                    // he either removes posted but unexecuted order (if any)
+                    if (MarketFailed(currLOB))
+                        return;
+                    currLOB.CancelLimitOrder(Utils::sgn(hedger.getOrderVolume()), hedger.getOrderPrice(), abs(hedger.getOrderVolume()));
+                    // and submit new order based on current LOB
+                    double p_hedger = 0.0, v_hedger = 0.0, t_q = (double)quar / n_quarters;
+                    int s_hedger = 0;
+                    hedger.PostOrder(p_hedger, v_hedger, s_hedger, exe_orders, currLOB, t_q);
+                    // LOB absorb hedger's order
+                    if (MarketFailed(currLOB))
+                        return;
+                    currLOB.AbsorbGeneralOrder(exe_order_hedger[0], LIMITORDER, p_hedger, v_hedger, s_hedger);
+                    // hedger updates inventories
+                    hedger.UpdateInventories(exe_order_hedger);
+                }
+                else
+                {
+                    // or he updates his inventories
+                    hedger.UpdateInventories(exe_orders);
                 }
-                // delta update from hedger's reevaluation, calculate gamma
-                time = day + (hour + 1) * 1. / n_hours;
-                hedger.ReCalcGreeks(time, lobs.back());
+
+                // record latest fundamental prices and lob
+                fund_prices.push_back(ph);
+                // the snapshot shares unchanged level chunks and the decay log with the previous one
+                lobs.push_back(currLOB);
             }
+            // delta update from hedger's reevaluation, calculate gamma
+            time = day + (hour + 1) * 1. / n_hours;
+            hedger.ReCalcGreeks(time, lobs.back());
         }
     }
-    catch (const std::out_of_range &e)
-    {
-        status = -1;
-    }
 }
 
-PathCollection::PathCollection(int n,
-                               const PathInfo &pi,
-                               const RandomInfo &ri)
+template <class Book>
+BasicPathCollection<Book>::BasicPathCollection(int n,
+                                               const BasicPathInfo<Book> &pi,
+                                               const RandomInfo &ri)
     : n_paths(n),
       path_info(pi),
       ran_info(ri)
 {
-    Path p_temp(pi, ri);
-    snapshots.resize(1, p_temp);
+    BasicPath<Book> p_temp(pi, ri);
+    snapshots.push_back(p_temp);
     for (int i = 1; i < n_paths; i++)
     {
-        RandomInfo ri_i(ri.seed + i, ri);
-        std::unique_ptr<Path> ptr_pth(new Path(pi, ri_i));
+        RandomInfo ri_i = ri.ForPath(i);
+        std::unique_ptr<BasicPath<Book>> ptr_pth(new BasicPath<Book>(pi, ri_i));
         snapshots.push_back(*ptr_pth);
     }
 }
 
-PathCollection::~PathCollection()
+template <class Book>
+BasicPathCollection<Book>::~BasicPathCollection()
 {
 }
 
-std::vector<double> PathCollection::getLOBVolumeTrajectories(int s, int path_id) const
+template <class Book>
+std::vector<double> BasicPathCollection<Book>::getLOBVolumeTrajectories(int s, int path_id) const
 {
     std::vector<double> volumes;
     auto &lobs = snapshots.at(path_id).lobs;
@@ -172,13 +192,15 @@ std::vector<double> PathCollection::getLOBVolumeTrajectories(int s, int path_id)
 }
 
 // this function should updates std::vector<Path> snapshots
-void PathCollection::GeneratePaths()
+template <class Book>
+void BasicPathCollection<Book>::GeneratePaths()
 {
     for (int i = 0; i < n_paths; i++)
         snapshots[i].GenOnePath();
 }
 
-void PathCollection::CalcLiquidityMetrics(std::vector<double> &res) const
+template <class Book>
+void BasicPathCollection<Book>::CalcLiquidityMetrics(std::vector<double> &res) const
 {
     res.resize(0);
     // 0. failure rate
@@ -222,13 +244,13 @@ void PathCollection::CalcLiquidityMetrics(std::vector<double> &res) const
     double l_1 = 0.0, l_2 = 0.0;
     for (int i_path : valid_idx)
     {
-        const std::vector<LOB> &lobs = snapshots[i_path].lobs;
+        const std::vector<Book> &lobs = snapshots[i_path].lobs;
         // 2.1 average bid-ask spread
         // TODO 2.2 total volume
         double l_1_path = 0.0;
         for (int i_p = 0; i_p < lobs.size() - 1; i_p++)
         {
-            const LOB &lob = lobs[i_p];
+            const Book &lob = lobs[i_p];
             double ba_spr = lob.ask() - lob.bid();
             l_1_path += ba_spr;
         }
@@ -241,7 +263,7 @@ void PathCollection::CalcLiquidityMetrics(std::vector<double> &res) const
     double d_1 = 0.0;
     for (int i_path : valid_idx)
     {
-        const std::vector<LOB> &lobs = snapshots[i_path].lobs;
+        const std::vector<Book> &lobs = snapshots[i_path].lobs;
         const std::vector<double> &f_ps = snapshots[i_path].fund_prices;
         double d_1_path = 0.0;
         for (int tau = 0; tau < lobs.size() - 1; tau++)
@@ -254,7 +276,8 @@ void PathCollection::CalcLiquidityMetrics(std::vector<double> &res) const
     res.push_back(d_1);
 }
 
-void PathCollection::FindPathsWithStatus(int status, std::vector<int> &indices) const
+template <class Book>
+void BasicPathCollection<Book>::FindPathsWithStatus(int status, std::vector<int> &indices) const
 {
     indices.resize(0);
     for (int i = 0; i < snapshots.size(); i++)
@@ -264,7 +287,8 @@ void PathCollection::FindPathsWithStatus(int status, std::vector<int> &indices)
     }
 }
 
-void PathCollection::PrintSimulationResults() const
+template <class Book>
+void BasicPathCollection<Book>::PrintSimulationResults() const
 {
     std::vector<double> results;
     CalcLiquidityMetrics(results);
@@ -298,11 +322,19 @@ void PathCollection::PrintSimulationResults() const
     std::cout << "==============================" << std::endl;
 }
 
-double PathCollection::getLiquidityMetrics(int index) const
+template <class Book>
+double BasicPathCollection<Book>::getLiquidityMetrics(int index) const
 {
     std::vector<double> res;
     CalcLiquidityMetrics(res);
     if (index < 0 || index >= res.size())
         throw std::invalid_argument("Results index out of the boundary.");
     return res.at(index);
-}
\ No newline at end of file
+}
+
+template struct BasicPathInfo<LOB>;
+template class BasicPath<LOB>;
+template class BasicPathCollection<LOB>;
+template struct BasicPathInfo<LadderLOB>;
+template class BasicPath<LadderLOB>;
+template class BasicPathCollection<LadderLOB>;
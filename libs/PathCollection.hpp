@@ -1,25 +1,28 @@
 #include <vector>
 #include "LOB.hpp"
+#include "LadderLOB.hpp"
 #include "Random.hpp"
 #include "DeltaHedger.hpp"
 
-struct PathInfo
+// paths simulate on the book type Book, LOB or LadderLOB, which the typedefs below name
+template <class Book>
+struct BasicPathInfo
 {
     int n_days;
     int n_hours;
     int n_quarters;
-    LOB lob_0; // includes decay coefficients
+    Book lob_0; // includes decay coefficients
     double p_0;
     double hedger_opt_pos;
     double hedger_implied_vol;
 
-    PathInfo(int _n_days,
-             int _n_hours,
-             int _n_quarters,
-             double _p_0,
-             const LOB &_lob_0,
-             double _h_opt_pos,
-             double _h_iv)
+    BasicPathInfo(int _n_days,
+                  int _n_hours,
+                  int _n_quarters,
+                  double _p_0,
+                  const Book &_lob_0,
+                  double _h_opt_pos,
+                  double _h_iv)
         : n_days(_n_days),
           n_hours(_n_hours),
           n_quarters(_n_quarters),
@@ -30,13 +33,17 @@ struct PathInfo
     {
     }
 
-    static void GenerateScenarios(std::vector<PathInfo> &scens,
+    static void GenerateScenarios(std::vector<BasicPathInfo> &scens,
                                   const Parameter &param_name,
                                   const std::vector<double> &range,
-                                  const PathInfo &template_pi);
+                                  const BasicPathInfo &template_pi);
 };
 
-class Path
+template <class Book>
+class BasicPathCollection;
+
+template <class Book>
+class BasicPath
 {
 private:
     const int n_days;
@@ -44,20 +51,28 @@ private:
     const int n_quarters;
     const RandomInfo ran_info;
 
-    int status;
+    int status;                        // 0, or -1 once a side of the book has run dry
     DeltaHedger hedger;
 
-    std::vector<LOB> lobs;             // quarter-wise
+    std::vector<Book> lobs;            // quarter-wise; LOB snapshots share unchanged level chunks with each other
     std::vector<double> mid_prices;    // tick-wise mid prices;
     std::vector<double> hedger_deltas; // hour-wise
     std::vector<double> hedger_gammas; // hour-wise
     std::vector<double> fund_prices;   // hour-wise
 
+    // a book with an empty side is market failure, which ends the path with status -1
+    inline bool MarketFailed(const Book &lob)
+    {
+        if (lob.oneSideEmpty())
+            status = -1;
+        return status == -1;
+    }
+
 public:
-    friend class PathCollection;
-    Path(const PathInfo &_path_info,
-         const RandomInfo &_ran_info);
-    ~Path();
+    friend class BasicPathCollection<Book>;
+    BasicPath(const BasicPathInfo<Book> &_path_info,
+              const RandomInfo &_ran_info);
+    ~BasicPath();
 
     inline int Status() const { return status; }
 
@@ -65,17 +80,18 @@ public:
     void GenOnePath();
 };
 
-class PathCollection
+template <class Book>
+class BasicPathCollection
 {
 private:
     int n_paths;
-    PathInfo path_info;
+    BasicPathInfo<Book> path_info;
     RandomInfo ran_info;
-    std::vector<Path> snapshots; // vector of size n_paths
+    std::vector<BasicPath<Book>> snapshots; // vector of size n_paths
 
 public:
-    PathCollection(int n, const PathInfo &pi, const RandomInfo &ri);
-    ~PathCollection();
+    BasicPathCollection(int n, const BasicPathInfo<Book> &pi, const RandomInfo &ri);
+    ~BasicPathCollection();
 
     std::vector<double> getLOBVolumeTrajectories(int s, int path_id) const;
 
@@ -86,3 +102,11 @@ public:
 
     double getLiquidityMetrics(int index) const;
 };
+
+typedef BasicPathInfo<LOB> PathInfo;
+typedef BasicPath<LOB> Path;
+typedef BasicPathCollection<LOB> PathCollection;
+// the same simulation on price ladders, see LadderLOB for the features it leaves out
+typedef BasicPathInfo<LadderLOB> LadderPathInfo;
+typedef BasicPath<LadderLOB> LadderPath;
+typedef BasicPathCollection<LadderLOB> LadderPathCollection;
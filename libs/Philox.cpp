@@ -0,0 +1,130 @@
+#include "Philox.hpp"
+
+const int Philox4x32::ROUNDS;
+
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9; // golden ratio
+static const uint32_t PHILOX_W1 = 0xBB67AE85; // sqrt(3) - 1
+
+Philox4x32::Philox4x32(uint64_t _key, uint64_t substream)
+{
+    key[0] = static_cast<uint32_t>(_key);
+    key[1] = static_cast<uint32_t>(_key >> 32);
+    Seek(substream, 0);
+}
+
+// one round of the Philox S-box on x under round keys k0, k1
+static inline void PhiloxRound(uint32_t &x0, uint32_t &x1, uint32_t &x2, uint32_t &x3, uint32_t k0, uint32_t k1)
+{
+    const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * x0;
+    const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * x2;
+    x0 = static_cast<uint32_t>(p1 >> 32) ^ x1 ^ k0;
+    x2 = static_cast<uint32_t>(p0 >> 32) ^ x3 ^ k1;
+    x1 = static_cast<uint32_t>(p1);
+    x3 = static_cast<uint32_t>(p0);
+}
+
+void Philox4x32::Block(const uint32_t c[4], const uint32_t k[2], uint32_t out[4])
+{
+    uint32_t x0 = c[0], x1 = c[1], x2 = c[2], x3 = c[3];
+    // round r is keyed by k + r * (W0, W1); the fixed trip count lets the compiler unroll it
+    for (uint32_t r = 0; r < ROUNDS; r++)
+        PhiloxRound(x0, x1, x2, x3, k[0] + r * PHILOX_W0, k[1] + r * PHILOX_W1);
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+// outputs of the block at the current counter, which then moves on to the next block
+void Philox4x32::Refill()
+{
+    Block(ctr, key, block);
+    if (!++ctr[0])
+        ++ctr[1];
+    idx = 0;
+}
+
+Philox4x32::result_type Philox4x32::operator()()
+{
+    if (idx == 4)
+        Refill();
+    return block[idx++];
+}
+
+// the next n outputs. whole blocks are made LANES at a time, as independent rounds
+// that the compiler can interleave or vectorise
+void Philox4x32::Generate(uint32_t *out, int n)
+{
+    const int LANES = 8;
+    int i = 0;
+    while (i < n && idx < 4)
+        out[i++] = block[idx++];
+    uint64_t b = static_cast<uint64_t>(ctr[1]) << 32 | ctr[0];
+    for (; i + 4 * LANES <= n; i += 4 * LANES, b += LANES)
+    {
+        uint32_t x0[LANES], x1[LANES], x2[LANES], x3[LANES];
+        for (int j = 0; j < LANES; j++)
+        {
+            x0[j] = static_cast<uint32_t>(b + j);
+            x1[j] = static_cast<uint32_t>((b + j) >> 32);
+            x2[j] = ctr[2];
+            x3[j] = ctr[3];
+        }
+        for (uint32_t r = 0; r < ROUNDS; r++)
+        {
+            const uint32_t k0 = key[0] + r * PHILOX_W0, k1 = key[1] + r * PHILOX_W1;
+            for (int j = 0; j < LANES; j++)
+                PhiloxRound(x0[j], x1[j], x2[j], x3[j], k0, k1);
+        }
+        for (int j = 0; j < LANES; j++)
+        {
+            out[i + 4 * j] = x0[j];
+            out[i + 4 * j + 1] = x1[j];
+            out[i + 4 * j + 2] = x2[j];
+            out[i + 4 * j + 3] = x3[j];
+        }
+    }
+    ctr[0] = static_cast<uint32_t>(b);
+    ctr[1] = static_cast<uint32_t>(b >> 32);
+    for (; i < n; i++)
+        out[i] = (*this)();
+}
+
+// skip the next z outputs in O(1)
+void Philox4x32::discard(unsigned long long z)
+{
+    const unsigned long long left = 4 - idx;
+    if (z < left)
+    {
+        idx += static_cast<int>(z);
+        return;
+    }
+    const uint64_t substream = static_cast<uint64_t>(ctr[3]) << 32 | ctr[2];
+    Seek(substream, Position() + z);
+}
+
+// move to output position of a substream, counted from its start
+void Philox4x32::Seek(uint64_t substream, unsigned long long position)
+{
+    const uint64_t b = position / 4;
+    ctr[0] = static_cast<uint32_t>(b);
+    ctr[1] = static_cast<uint32_t>(b >> 32);
+    ctr[2] = static_cast<uint32_t>(substream);
+    ctr[3] = static_cast<uint32_t>(substream >> 32);
+    idx = 4;
+    if (position % 4)
+    {
+        Refill();
+        idx = static_cast<int>(position % 4);
+    }
+}
+
+// number of outputs handed out since the start of the substream
+unsigned long long Philox4x32::Position() const
+{
+    const uint64_t next = static_cast<uint64_t>(ctr[1]) << 32 | ctr[0];
+    // the counter already points past the block being handed out, unless none has been drawn
+    return idx == 4 ? next * 4 : (next - 1) * 4 + idx;
+}
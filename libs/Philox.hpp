@@ -0,0 +1,41 @@
+#ifndef microhedger_utilities_philox_hpp
+#define microhedger_utilities_philox_hpp
+
+#include <cstdint>
+
+// counter-based generator Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// each output block is a keyed bijection of a 128 bit counter, so a stream is addressed by its key and
+// substream with nothing to carry over from other streams, and jumping anywhere in it is O(1).
+// the counter holds the substream in its upper 64 bits and the block in its lower 64 bits.
+// meets the requirements of a uniform random bit generator, to be used with the <random> distributions
+class Philox4x32
+{
+private:
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t block[4]; // outputs for the current counter
+    int idx;           // next output of block to hand out; 4 when the block is used up
+
+    void Refill();
+
+public:
+    typedef uint32_t result_type;
+    static const int ROUNDS = 10;
+
+    Philox4x32(uint64_t _key = 0, uint64_t substream = 0);
+    ~Philox4x32() {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()();
+    void Generate(uint32_t *out, int n);
+    void discard(unsigned long long z);
+    void Seek(uint64_t substream, unsigned long long position);
+    unsigned long long Position() const;
+
+    // one block of outputs for counter c under key k, the primitive the engine is built on
+    static void Block(const uint32_t c[4], const uint32_t k[2], uint32_t out[4]);
+};
+
+#endif
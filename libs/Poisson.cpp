@@ -0,0 +1,32 @@
+#include <vector>
+#include "Poisson.hpp"
+
+const double Poisson::PTRS_MIN = 10.0;
+
+Poisson::Poisson(double mean)
+    : mu(mean),
+      exp_neg_mu(std::exp(-mean)),
+      log_mu(mean > 0.0 ? std::log(mean) : 0.0)
+{
+    b = 0.931 + 2.53 * std::sqrt(mu);
+    a = -0.059 + 0.02483 * b;
+    log_inv_alpha = std::log(1.1239 + 1.1328 / (b - 3.4));
+    v_r = 0.9277 - 3.6224 / (b - 2.0);
+}
+
+double Poisson::LogFactorial(int k)
+{
+    static const int TABLE_SIZE = 256;
+    static const std::vector<double> table = []() -> std::vector<double>
+    {
+        std::vector<double> t(TABLE_SIZE, 0.0);
+        for (int i = 2; i < TABLE_SIZE; i++)
+            t[i] = t[i - 1] + std::log(static_cast<double>(i));
+        return t;
+    }();
+    if (k < TABLE_SIZE)
+        return table[k];
+    // log Gamma(x) for x = k + 1 > 256, where the series has converged to double precision
+    const double x = k + 1.0, r = 1.0 / (x * x);
+    return (x - 0.5) * std::log(x) - x + 0.91893853320467274178 + (1.0 / 12.0 - r * (1.0 / 360.0 - r / 1260.0)) / x;
+}
@@ -0,0 +1,62 @@
+#ifndef microhedger_utilities_poisson_hpp
+#define microhedger_utilities_poisson_hpp
+
+#include <cmath>
+
+// Poisson sampler whose cost does not grow with its mean. means of at least PTRS_MIN use the
+// transformed rejection with squeeze (PTRS) of Hormann (1993), which accepts about 90% of its
+// pairs of uniforms without evaluating any logs; smaller ones search the cdf from 0.
+// the constants of either method are computed once per mean, at construction
+class Poisson
+{
+private:
+    double mu;
+    double exp_neg_mu;   // P(0), for the search
+    double log_mu;       // constants of PTRS
+    double b, a, log_inv_alpha, v_r;
+
+public:
+    static const double PTRS_MIN;
+
+    Poisson(double mean = 1.0);
+    ~Poisson() {}
+
+    inline double Mean() const { return mu; }
+    // log k!, from a table for small k and Stirling's series beyond it
+    static double LogFactorial(int k);
+
+    // a draw from next(), which returns uniforms on [0, 1)
+    template <class Uniform>
+    int Sample(Uniform &&next) const
+    {
+        if (mu <= 0.0)
+            return 0;
+        if (mu < PTRS_MIN)
+        {
+            const double u = next();
+            int k = 0;
+            double p = exp_neg_mu, cdf = p;
+            while (u > cdf && p > 0.0)
+            {
+                p *= mu / ++k;
+                cdf += p;
+            }
+            return k;
+        }
+        for (;;)
+        {
+            const double u = next() - 0.5;
+            const double v = next();
+            const double us = 0.5 - std::fabs(u);
+            const double k = std::floor((2.0 * a / us + b) * u + mu + 0.43);
+            if (us >= 0.07 && v <= v_r)
+                return static_cast<int>(k);
+            if (k < 0.0 || (us < 0.013 && v > us))
+                continue;
+            if (std::log(v) + log_inv_alpha - std::log(a / (us * us) + b) <= -mu + k * log_mu - LogFactorial(static_cast<int>(k)))
+                return static_cast<int>(k);
+        }
+    }
+};
+
+#endif
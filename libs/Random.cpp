@@ -1,3 +1,5 @@
+#include <cmath>
+#include <algorithm>
 #include "Random.hpp"
 
 void RandomInfo::GenerateScenarios(std::vector<RandomInfo> &scens,
@@ -51,6 +53,19 @@ void RandomInfo::GenerateScenarios(std::vector<RandomInfo> &scens,
 
 }
 
+// the random info of path i of a collection; the original engine steps the seed, while a counter-based
+// one keeps it as the key of the whole collection and tells paths apart by stream
+RandomInfo RandomInfo::ForPath(int i) const
+{
+    if (engine == PHILOX_ENGINE)
+    {
+        RandomInfo ri(*this);
+        ri.stream = i;
+        return ri;
+    }
+    return RandomInfo(seed + i, *this);
+}
+
 Random::Random(int _seed,
                double _vol_news,
                double _order_intensity,
@@ -59,9 +74,14 @@ Random::Random(int _seed,
                double _v_min, double _v_max,
                double _mean_spread, double _vol_spread,
                double _prob_sign)
-    : generator(std::default_random_engine(_seed)),
+    : engine(MINSTD_ENGINE),
+      normal(POLAR_NORMAL),
+      counts(STD_POISSON),
+      substreams(false),
+      generator(std::default_random_engine(_seed)),
       norm_dist_p_shock(std::normal_distribution<double>(0.0, _vol_news)),
       pois_dist_onum(std::poisson_distribution<int>(_order_intensity)),
+      ptrs_onum(_order_intensity),
       ber_dist_otype(std::bernoulli_distribution(_prob_otype)),
       ber_dist_info(std::bernoulli_distribution(_prob_info)),
       uni_dist_v_mm(std::uniform_real_distribution<double>(_v_min, _v_max)),
@@ -75,16 +95,185 @@ Random::Random(const RandomInfo &ri)
              ri.prob_info, ri.v_min, ri.v_max, ri.mean_spread, ri.vol_spread,
              ri.prob_sign)
 {
+    engine = ri.engine;
+    normal = ri.normal;
+    counts = ri.counts;
+    substreams = ri.substreams;
+    if (substreams && engine != PHILOX_ENGINE)
+        throw std::invalid_argument("Substreams need a counter-based engine.");
+    if (engine == PHILOX_ENGINE)
+    {
+        const uint64_t key = static_cast<uint32_t>(ri.seed) | static_cast<uint64_t>(static_cast<uint32_t>(ri.stream)) << 32;
+        philox = Philox4x32(key);
+        // substream 0 is the single stream, so the components take 1 onwards
+        if (substreams)
+            for (int c = 0; c < N_COMPONENTS; c++)
+                streams[c] = Philox4x32(key, c + 1);
+    }
 }
 
 double Random::GenerateShockedPrice(double p_prev)
 {
-    return p_prev + norm_dist_p_shock(generator);
+    return p_prev + (engine == PHILOX_ENGINE ? Normal(Stream(NEWS_SHOCKS), norm_dist_p_shock) : Normal(generator, norm_dist_p_shock));
+}
+
+// a uniform 32 bit word from the original engine, whose outputs span only [1, 2^31 - 2]
+uint32_t Random::Word(std::default_random_engine &g)
+{
+    // the distribution holds no state between draws, so a local one costs nothing and is not shared between threads
+    std::uniform_int_distribution<uint32_t> word_dist(0, 0xFFFFFFFF);
+    return word_dist(g);
+}
+
+// a draw of dist from the selected sampler
+template <class Engine>
+double Random::Normal(Engine &g, std::normal_distribution<double> &dist)
+{
+    if (normal == ZIGGURAT_NORMAL)
+        return dist.mean() + dist.stddev() * Ziggurat::Standard().Sample([&g]() { return Word(g); });
+    return dist(g);
 }
 
 int Random::GenerateNumOrders()
 {
-    return pois_dist_onum(generator);
+    if (counts == PTRS_POISSON)
+    {
+        if (engine == PHILOX_ENGINE)
+        {
+            Philox4x32 &g = Stream(ARRIVALS);
+            return ptrs_onum.Sample([&g]() { return g() * (1.0 / 4294967296.0); }); // as in FillUniforms
+        }
+        return ptrs_onum.Sample([this]() { return std::generate_canonical<double, 53>(generator); });
+    }
+    return engine == PHILOX_ENGINE ? pois_dist_onum(Stream(ARRIVALS)) : pois_dist_onum(generator);
+}
+
+// with PTRS the uniforms come in bulk, about as many as the counts take on average: one each for a
+// small mean, which is found by search, and 2 / 0.9 each for a larger one; the rest come in small blocks
+void Random::GenerateNumOrders(int n, std::vector<int> &n_orders)
+{
+    n_orders.resize(n);
+    if (counts != PTRS_POISSON)
+    {
+        for (int i = 0; i < n; i++)
+            n_orders[i] = GenerateNumOrders();
+        return;
+    }
+    const int BLOCK = 16;
+    int m = ptrs_onum.Mean() < Poisson::PTRS_MIN ? n : (20 * n) / 9;
+    uniforms.resize(std::max(m, BLOCK));
+    FillUniforms(uniforms.data(), m, ARRIVALS);
+    int j = 0;
+    auto next = [this, &j, &m, BLOCK]()
+    {
+        if (j == m)
+        {
+            m = BLOCK;
+            FillUniforms(uniforms.data(), m, ARRIVALS);
+            j = 0;
+        }
+        return uniforms[j++];
+    };
+    for (int i = 0; i < n; i++)
+        n_orders[i] = ptrs_onum.Sample(next);
+}
+
+// skip the next z raw outputs of the engine, or of each substream, in O(1) for a counter-based one;
+// draws cached by the distributions are dropped so that what follows depends on the position alone
+void Random::JumpAhead(unsigned long long z)
+{
+    if (substreams)
+        for (int c = 0; c < N_COMPONENTS; c++)
+            streams[c].discard(z);
+    else if (engine == PHILOX_ENGINE)
+        philox.discard(z);
+    else
+        generator.discard(z);
+    norm_dist_p_shock.reset();
+    pois_dist_onum.reset();
+    norm_dist_p_mm.reset();
+}
+
+// n uniforms on [0, 1); from a counter-based engine each is one of its 32 bit outputs scaled down,
+// which is resolution enough for the thresholds and ranges they are mapped to
+void Random::FillUniforms(double *u, int n, RandomComponent c)
+{
+    if (engine != PHILOX_ENGINE)
+    {
+        for (int i = 0; i < n; i++)
+            u[i] = std::generate_canonical<double, 53>(generator);
+        return;
+    }
+    bits.resize(n);
+    Stream(c).Generate(bits.data(), n);
+    const double scale = 1.0 / 4294967296.0; // 2^-32
+    for (int i = 0; i < n; i++)
+        u[i] = bits[i] * scale;
+}
+
+// n normals by Box-Muller, which turns pairs of uniforms into pairs of normals without rejection,
+// or by the Ziggurat over a block of words, which needs neither log nor trig on its fast path
+void Random::FillNormals(double *x, int n, double mean, double sd, RandomComponent c)
+{
+    if (normal == ZIGGURAT_NORMAL)
+    {
+        bits.resize(n);
+        if (engine == PHILOX_ENGINE)
+        {
+            Philox4x32 &g = Stream(c);
+            g.Generate(bits.data(), n);
+            Ziggurat::Standard().Fill(bits.data(), n, x, mean, sd, [&g]() { return g(); });
+        }
+        else
+        {
+            for (int i = 0; i < n; i++)
+                bits[i] = Word(generator);
+            Ziggurat::Standard().Fill(bits.data(), n, x, mean, sd, [this]() { return Word(generator); });
+        }
+        return;
+    }
+    const int m = (n + 1) / 2;
+    uniforms.resize(2 * m);
+    FillUniforms(uniforms.data(), 2 * m, c);
+    const double *u1 = uniforms.data();
+    const double *u2 = u1 + m;
+    const double two_pi = 2.0 * M_PI;
+    for (int i = 0; i < n / 2; i++)
+    {
+        const double r = sd * std::sqrt(-2.0 * std::log(1.0 - u1[i]));
+        x[i] = mean + r * std::cos(two_pi * u2[i]);
+        x[m + i] = mean + r * std::sin(two_pi * u2[i]);
+    }
+    if (n % 2)
+        x[m - 1] = mean + sd * std::sqrt(-2.0 * std::log(1.0 - u1[m - 1])) * std::cos(two_pi * u2[m - 1]);
+}
+
+void Random::GenerateOrders(int n, OrderDraws &draws)
+{
+    draws.limit.resize(n);
+    draws.informed.resize(n);
+    draws.s.resize(n);
+    draws.v.resize(n);
+    draws.spread.resize(n);
+    if (n <= 0)
+        return;
+    FillNormals(draws.spread.data(), n, norm_dist_p_mm.mean(), norm_dist_p_mm.stddev(), ORDER_SPREADS);
+    uniforms.resize(4 * n);
+    double *u = uniforms.data();
+    FillUniforms(u, n, ORDER_TYPES);
+    FillUniforms(u + n, n, INFORMED_FLAGS);
+    FillUniforms(u + 2 * n, n, ORDER_SIGNS);
+    FillUniforms(u + 3 * n, n, ORDER_VOLUMES);
+    const double p_limit = ber_dist_otype.p(), p_info = ber_dist_info.p(), p_sign = ber_dist_sign.p();
+    const double v_min = uni_dist_v_mm.a(), v_range = uni_dist_v_mm.b() - uni_dist_v_mm.a();
+    for (int i = 0; i < n; i++)
+        draws.limit[i] = u[i] < p_limit;
+    for (int i = 0; i < n; i++)
+        draws.informed[i] = u[n + i] < p_info;
+    for (int i = 0; i < n; i++)
+        draws.s[i] = u[2 * n + i] < p_sign ? 1 : -1;
+    for (int i = 0; i < n; i++)
+        draws.v[i] = v_min + v_range * u[3 * n + i];
 }
 
 void Random::GenerateOrder(OrderType &o_type, // [O] - LIMITORDER or MARKETORDER
@@ -94,9 +283,20 @@ void Random::GenerateOrder(OrderType &o_type, // [O] - LIMITORDER or MARKETORDER
                            double p_mid,      // [I] - mid price of the LOB for uninformed agents
                            double p_fund)     // [I] - current fundamental price for informed agents
 {
-    o_type = ber_dist_otype(generator) ? LIMITORDER : MARKETORDER;
-    v = uni_dist_v_mm(generator);
-    bool informed = ber_dist_info(generator);
+    if (substreams)
+        GenerateOrderFromStreams(o_type, p, v, s, p_mid, p_fund);
+    else if (engine == PHILOX_ENGINE)
+        GenerateOrderFrom(philox, o_type, p, v, s, p_mid, p_fund);
+    else
+        GenerateOrderFrom(generator, o_type, p, v, s, p_mid, p_fund);
+}
+
+template <class Engine>
+void Random::GenerateOrderFrom(Engine &g, OrderType &o_type, double &p, double &v, int &s, double p_mid, double p_fund)
+{
+    o_type = ber_dist_otype(g) ? LIMITORDER : MARKETORDER;
+    v = uni_dist_v_mm(g);
+    bool informed = ber_dist_info(g);
     double p_sign = ber_dist_sign.param().p();
     switch (o_type)
     {
@@ -105,18 +305,32 @@ void Random::GenerateOrder(OrderType &o_type, // [O] - LIMITORDER or MARKETORDER
         if (informed)
             s = p_mid > p_fund ? 1 : -1; // sell when current price > fundamentals; buy otherwise
         else
-            s = ber_dist_sign(generator) > p_sign ? 1 : -1;
+            s = ber_dist_sign(g) > p_sign ? 1 : -1;
         break;
     }
     case LIMITORDER:
     {
-        s = ber_dist_sign(generator) > p_sign ? 1 : -1;
+        s = ber_dist_sign(g) > p_sign ? 1 : -1;
         // informed market makers use fundamental price as reference,
         // while uninformed ones use mid prices
-        p = (informed ? p_fund : p_mid) - s * norm_dist_p_mm(generator);
+        p = (informed ? p_fund : p_mid) - s * Normal(g, norm_dist_p_mm);
         break;
     }
     default:
         throw std::invalid_argument("Invalid order type.");
     }
-}
\ No newline at end of file
+}
+// each component from its own substream, drawn for every order whether it needs it or not, so that
+// the i-th order of a path takes the i-th draws of each substream under any parameters
+void Random::GenerateOrderFromStreams(OrderType &o_type, double &p, double &v, int &s, double p_mid, double p_fund)
+{
+    o_type = ber_dist_otype(streams[ORDER_TYPES]) ? LIMITORDER : MARKETORDER;
+    v = uni_dist_v_mm(streams[ORDER_VOLUMES]);
+    const bool informed = ber_dist_info(streams[INFORMED_FLAGS]);
+    s = ber_dist_sign(streams[ORDER_SIGNS]) ? 1 : -1;
+    const double spread = Normal(streams[ORDER_SPREADS], norm_dist_p_mm);
+    if (o_type == LIMITORDER)
+        p = (informed ? p_fund : p_mid) - s * spread;
+    else if (informed)
+        s = p_mid > p_fund ? 1 : -1;
+}
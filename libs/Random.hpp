@@ -3,10 +3,37 @@
 
 #include <random>
 #include "Utils.hpp"
+#include "Philox.hpp"
+#include "Ziggurat.hpp"
+#include "Poisson.hpp"
+
+enum RandomEngine
+{
+    MINSTD_ENGINE = 0, // std::default_random_engine seeded with seed + path index, the original streams
+    PHILOX_ENGINE = 1  // Philox4x32 keyed by (seed, path index), independent and addressable in any order
+};
+
+enum NormalSampler
+{
+    POLAR_NORMAL = 0,   // std::normal_distribution, the original draws
+    ZIGGURAT_NORMAL = 1 // Ziggurat, one 32 bit word per draw but for about 1.2% of them
+};
+
+enum CountSampler
+{
+    STD_POISSON = 0, // std::poisson_distribution, the original draws
+    PTRS_POISSON = 1 // Poisson, in constant time however high the order intensity
+};
 
 struct RandomInfo
 {
     int seed;
+    RandomEngine engine;
+    int stream;       // path index keying the stream of a counter-based engine
+    bool batch_draws; // draw each quarter's orders up front with Random::GenerateOrders
+    NormalSampler normal; // sampler of news shocks and market makers' spreads
+    CountSampler counts;  // sampler of the number of orders in each subinterval
+    bool substreams;      // draw each component from its own substream, see Random; needs PHILOX_ENGINE
     double vol_news;
     double order_intensity;
     double prob_otype;
@@ -24,6 +51,12 @@ struct RandomInfo
                double _mean_spread, double _vol_spread,
                double _prob_sign)
         : seed(_seed),
+          engine(MINSTD_ENGINE),
+          stream(0),
+          batch_draws(false),
+          normal(POLAR_NORMAL),
+          counts(STD_POISSON),
+          substreams(false),
           vol_news(_vol_news),
           order_intensity(_order_intensity),
           prob_otype(_prob_otype),
@@ -43,24 +76,87 @@ struct RandomInfo
         seed = _seed;
     }
 
+    RandomInfo ForPath(int i) const;
+
     static void GenerateScenarios(std::vector<RandomInfo> &scens,
                                   const Parameter &param_name,
                                   const std::vector<double> &range,
                                   const RandomInfo &ri_template);
 };
 
+// the draws behind a run of orders, made up front in bulk as parallel arrays; only the mapping
+// of an order's draws to its sign and price, which needs the book, is left for its tick
+struct OrderDraws
+{
+    std::vector<char> limit;    // whether each order is a limit order
+    std::vector<char> informed; // whether it comes from an informed agent
+    std::vector<int> s;         // its sign, unless an informed market order follows the fundamentals
+    std::vector<double> v;      // its volume
+    std::vector<double> spread; // distance of a limit order from its reference price
+
+    inline int Size() const { return static_cast<int>(v.size()); }
+    // order i of the run, as Random::GenerateOrder would make it
+    inline void Order(int i, OrderType &o_type, double &p, double &v_i, int &s_i, double p_mid, double p_fund) const
+    {
+        o_type = limit[i] ? LIMITORDER : MARKETORDER;
+        v_i = v[i];
+        s_i = s[i];
+        if (o_type == LIMITORDER)
+            p = (informed[i] ? p_fund : p_mid) - s_i * spread[i];
+        else if (informed[i])
+            s_i = p_mid > p_fund ? 1 : -1;
+    }
+};
+
+// the stochastic components of the simulation, each with its own substream when asked for. with
+// substreams, every order draws all of its components, so that the same draws meet the same order
+// under any parameters and scenarios that share a seed see common random numbers
+enum RandomComponent
+{
+    ARRIVALS = 0,
+    ORDER_TYPES,
+    INFORMED_FLAGS,
+    ORDER_SIGNS,
+    ORDER_VOLUMES,
+    ORDER_SPREADS,
+    NEWS_SHOCKS,
+    N_COMPONENTS
+};
+
 class Random
 {
 private:
+    RandomEngine engine;
+    NormalSampler normal;
+    CountSampler counts;
+    bool substreams;
     std::default_random_engine generator;
+    Philox4x32 philox;
+    Philox4x32 streams[N_COMPONENTS]; // substreams of philox's key, one per component
     std::normal_distribution<double> norm_dist_p_shock;   // news shocks on fundamental price
     std::poisson_distribution<int> pois_dist_onum;        // number of orders at each subinterval
+    Poisson ptrs_onum;                                    // the same, for PTRS_POISSON
     std::bernoulli_distribution ber_dist_otype;           // type of external orders
     std::bernoulli_distribution ber_dist_info;            // portions of informed/uninformed external orders
     std::uniform_real_distribution<double> uni_dist_v_mm; // volumes of external orders
     std::normal_distribution<double> norm_dist_p_mm;      // spread prices of external orders from market makers
     std::bernoulli_distribution ber_dist_sign;            // sign of external orders
 
+    std::vector<double> uniforms;  // scratch of the bulk generators
+    std::vector<uint32_t> bits;
+
+    static uint32_t Word(std::default_random_engine &g);
+    inline static uint32_t Word(Philox4x32 &g) { return g(); }
+    template <class Engine>
+    double Normal(Engine &g, std::normal_distribution<double> &dist);
+    template <class Engine>
+    void GenerateOrderFrom(Engine &g, OrderType &o_type, double &p, double &v, int &s, double p_mid, double p_fund);
+    void GenerateOrderFromStreams(OrderType &o_type, double &p, double &v, int &s, double p_mid, double p_fund);
+    // the counter-based stream of component c
+    inline Philox4x32 &Stream(RandomComponent c) { return substreams ? streams[c] : philox; }
+    void FillUniforms(double *u, int n, RandomComponent c);
+    void FillNormals(double *x, int n, double mean, double sd, RandomComponent c);
+
 public:
     Random(int _seed,
            double _vol_news,
@@ -75,12 +171,18 @@ public:
 
     double GenerateShockedPrice(double p_prev);
     int GenerateNumOrders();
+    // the numbers of orders of n subintervals at once
+    void GenerateNumOrders(int n, std::vector<int> &n_orders);
+    void JumpAhead(unsigned long long z);
     void GenerateOrder(OrderType &o_type, // [O] - LIMITORDER or MARKETORDER
                        double &p,         // [O] - price of the external order
                        double &v,         // [O] - volume of the external order
                        int &s,            // [O] - sign of the external order
                        double p_mid,      // [I] - mid price of the LOB for uninformed agents
                        double p_fund);    // [I] - current fundamental price for informed agents
+    // draw n orders ahead in bulk, to be mapped by OrderDraws::Order; the draws differ from
+    // those of n calls to GenerateOrder, which only draws what each order turns out to need
+    void GenerateOrders(int n, OrderDraws &draws);
 };
 
 #endif
@@ -0,0 +1,20 @@
+#ifndef microhedger_utilities_safety_policy_hpp
+#define microhedger_utilities_safety_policy_hpp
+
+// compile-time choice of whether a book checks at every public call that neither side is empty,
+// which signals market failure. an unchecked book carries no such test, so its caller has to
+// detect market failure itself
+
+// throw std::out_of_range from any public call on a book with an empty side
+struct CheckedCalls
+{
+    static const bool ENABLED = true;
+};
+
+// leave market failure to the caller
+struct UncheckedCalls
+{
+    static const bool ENABLED = false;
+};
+
+#endif
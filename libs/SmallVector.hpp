@@ -0,0 +1,185 @@
+#ifndef microhedger_utilities_small_vector_hpp
+#define microhedger_utilities_small_vector_hpp
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// vector whose first N elements live inside the object itself, spilling to the heap only beyond that,
+// so that copying a small one costs no allocation. supports the subset of std::vector used by the book
+template <class T, int N>
+class SmallVector
+{
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type inline_buf[N];
+    T *ptr;  // inline_buf, or heap storage after spilling
+    int n;   // number of elements
+    int cap; // N, or the size of heap storage
+
+    inline T *InlineData() { return reinterpret_cast<T *>(inline_buf); }
+    inline bool Spilled() const { return cap > N; }
+
+    void Grow(int new_cap)
+    {
+        T *buf = static_cast<T *>(::operator new(sizeof(T) * new_cap));
+        for (int i = 0; i < n; i++)
+        {
+            new (buf + i) T(std::move(ptr[i]));
+            ptr[i].~T();
+        }
+        if (Spilled())
+            ::operator delete(ptr);
+        ptr = buf;
+        cap = new_cap;
+    }
+
+    // takes the heap storage of other, or moves its inline elements one by one, and leaves it empty
+    void Steal(SmallVector &other)
+    {
+        if (other.Spilled())
+        {
+            ptr = other.ptr;
+            n = other.n;
+            cap = other.cap;
+            other.ptr = other.InlineData();
+            other.n = 0;
+            other.cap = N;
+            return;
+        }
+        for (int i = 0; i < other.n; i++)
+            new (ptr + n++) T(std::move(other.ptr[i]));
+        other.clear();
+    }
+
+    // storage back to the inline buffer, with no elements
+    void Release()
+    {
+        clear();
+        if (Spilled())
+            ::operator delete(ptr);
+        ptr = InlineData();
+        cap = N;
+    }
+
+public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    SmallVector() : ptr(InlineData()), n(0), cap(N) {}
+    SmallVector(int count, const T &value) : SmallVector() { resize(count, value); }
+    // a range of forward iterators; anything else, such as SmallVector<int>(3, 7), is (count, value)
+    template <class It, class = typename std::enable_if<std::is_convertible<
+                            typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag>::value>::type>
+    SmallVector(It first, It last) : SmallVector() { assign(first, last); }
+    SmallVector(const SmallVector &other) : SmallVector() { assign(other.begin(), other.end()); }
+    SmallVector(SmallVector &&other) : SmallVector() { Steal(other); }
+    SmallVector &operator=(const SmallVector &other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+    SmallVector &operator=(SmallVector &&other)
+    {
+        if (this != &other)
+        {
+            Release();
+            Steal(other);
+        }
+        return *this;
+    }
+    ~SmallVector() { Release(); }
+
+    inline int size() const { return n; }
+    inline bool empty() const { return !n; }
+    inline int capacity() const { return cap; }
+    inline T *data() { return ptr; }
+    inline const T *data() const { return ptr; }
+    inline iterator begin() { return ptr; }
+    inline iterator end() { return ptr + n; }
+    inline const_iterator begin() const { return ptr; }
+    inline const_iterator end() const { return ptr + n; }
+    inline T &operator[](int i) { return ptr[i]; }
+    inline const T &operator[](int i) const { return ptr[i]; }
+    inline T &back() { return ptr[n - 1]; }
+    inline const T &back() const { return ptr[n - 1]; }
+
+    void clear()
+    {
+        for (int i = 0; i < n; i++)
+            ptr[i].~T();
+        n = 0;
+    }
+
+    void push_back(const T &value)
+    {
+        if (n == cap)
+        {
+            T copy(value); // value may live in this vector
+            Grow(2 * cap);
+            new (ptr + n) T(std::move(copy));
+        }
+        else
+            new (ptr + n) T(value);
+        n++;
+    }
+
+    void pop_back()
+    {
+        ptr[--n].~T();
+    }
+
+    iterator insert(iterator pos, const T &value)
+    {
+        int i = static_cast<int>(pos - ptr);
+        T copy(value);
+        if (n == cap)
+            Grow(2 * cap);
+        if (i == n)
+            new (ptr + n) T(std::move(copy));
+        else
+        {
+            new (ptr + n) T(std::move(ptr[n - 1]));
+            for (int j = n - 1; j > i; j--)
+                ptr[j] = std::move(ptr[j - 1]);
+            ptr[i] = std::move(copy);
+        }
+        n++;
+        return ptr + i;
+    }
+
+    iterator erase(iterator pos)
+    {
+        int i = static_cast<int>(pos - ptr);
+        for (int j = i; j < n - 1; j++)
+            ptr[j] = std::move(ptr[j + 1]);
+        pop_back();
+        return ptr + i;
+    }
+
+    void resize(int count, const T &value = T())
+    {
+        if (count > cap)
+            Grow(count);
+        while (n > count)
+            pop_back();
+        while (n < count)
+            new (ptr + n++) T(value);
+    }
+
+    template <class It>
+    void assign(It first, It last)
+    {
+        clear();
+        int count = static_cast<int>(std::distance(first, last));
+        if (count > cap)
+            Grow(count);
+        for (; first != last; ++first)
+            new (ptr + n++) T(*first);
+    }
+};
+
+#endif
@@ -23,6 +23,15 @@ enum OrderType
     MARKETORDER = 1
 };
 
+// an incoming order as generated by Random::GenerateOrder; p is ignored for market orders
+struct Order
+{
+    OrderType type;
+    double p;
+    double v;
+    int s;
+};
+
 enum OptionType
 {
     CALL = 0,
@@ -0,0 +1,30 @@
+#include "Ziggurat.hpp"
+
+// tables of Marsaglia and Tsang for hz spanning 32 bit integers, layer 0 being the base with the tail
+Ziggurat::Ziggurat()
+{
+    const double m = 2147483648.0; // 2^31
+    const double v = 9.91256303526217e-3; // area of each layer
+    double dn = 3.442619855899, tn = dn;
+    const double q = v / std::exp(-0.5 * dn * dn);
+    k[0] = static_cast<uint32_t>((dn / q) * m);
+    k[1] = 0;
+    w[0] = q / m;
+    w[LAYERS - 1] = dn / m;
+    f[0] = 1.0;
+    f[LAYERS - 1] = std::exp(-0.5 * dn * dn);
+    for (int i = LAYERS - 2; i >= 1; i--)
+    {
+        dn = std::sqrt(-2.0 * std::log(v / dn + std::exp(-0.5 * dn * dn)));
+        k[i + 1] = static_cast<uint32_t>((dn / tn) * m);
+        tn = dn;
+        f[i] = std::exp(-0.5 * dn * dn);
+        w[i] = dn / m;
+    }
+}
+
+const Ziggurat &Ziggurat::Standard()
+{
+    static const Ziggurat tables;
+    return tables;
+}
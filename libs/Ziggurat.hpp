@@ -0,0 +1,83 @@
+#ifndef microhedger_utilities_ziggurat_hpp
+#define microhedger_utilities_ziggurat_hpp
+
+#include <cstdint>
+#include <cmath>
+
+// standard normal sampler by the ziggurat method of Marsaglia and Tsang (2000), 128 layers.
+// a draw takes one 32 bit word and, for all but about 1.2% of them, a table lookup, a multiply and a
+// compare. the top 7 bits of the word pick the layer and the other 25 give the signed abscissa, so that
+// unlike the original the layer and the value never share bits
+class Ziggurat
+{
+private:
+    static const int LAYERS = 128;
+    uint32_t k[LAYERS]; // |hz| below k[i] lies inside the rectangle of layer i
+    double w[LAYERS];   // scale from hz to x for layer i
+    double f[LAYERS];   // density at the edge of layer i
+
+    Ziggurat();
+
+    // the draw for a word that missed the fast path, drawing more words from next as needed
+    template <class Bits>
+    double Slow(int32_t hz, int i, Bits &next) const
+    {
+        const double R = 3.442619855899; // start of the tail
+        for (;;)
+        {
+            const double x = hz * w[i];
+            if (i == 0)
+            {
+                // Marsaglia's tail method
+                double xt, y;
+                do
+                {
+                    xt = -std::log(Uniform(next())) / R;
+                    y = -std::log(Uniform(next()));
+                } while (y + y < xt * xt);
+                return hz > 0 ? R + xt : -R - xt;
+            }
+            if (f[i] + Uniform(next()) * (f[i - 1] - f[i]) < std::exp(-0.5 * x * x))
+                return x;
+            const uint32_t word = next();
+            i = word >> 25;
+            hz = static_cast<int32_t>(word << 7);
+            if (Magnitude(hz) < k[i])
+                return hz * w[i];
+        }
+    }
+
+    inline static uint32_t Magnitude(int32_t hz) { return hz < 0 ? 0u - static_cast<uint32_t>(hz) : hz; }
+    inline static double Uniform(uint32_t word) { return (word + 0.5) * (1.0 / 4294967296.0); } // in (0, 1)
+
+public:
+    // the shared tables, built on first use
+    static const Ziggurat &Standard();
+
+    // a standard normal from next(), which returns uniformly random 32 bit words
+    template <class Bits>
+    double Sample(Bits &&next) const
+    {
+        const uint32_t word = next();
+        const int i = word >> 25;
+        const int32_t hz = static_cast<int32_t>(word << 7);
+        if (Magnitude(hz) < k[i])
+            return hz * w[i];
+        return Slow(hz, i, next);
+    }
+
+    // n normals of mean and sd from n words, taking more from next for the few that miss the fast path
+    template <class Bits>
+    void Fill(const uint32_t *words, int n, double *x, double mean, double sd, Bits &&next) const
+    {
+        for (int j = 0; j < n; j++)
+        {
+            const int i = words[j] >> 25;
+            const int32_t hz = static_cast<int32_t>(words[j] << 7);
+            const double z = Magnitude(hz) < k[i] ? hz * w[i] : Slow(hz, i, next);
+            x[j] = mean + sd * z;
+        }
+    }
+};
+
+#endif
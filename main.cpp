@@ -5,6 +5,9 @@
 
 namespace plt = matplotlibcpp;
 
+// book the paths run on; LadderLOB trades the features listed in LadderLOB.hpp for a flat ladder of ticks
+typedef LOB Book;
+
 int main()
 {
     const int T = 20;
@@ -20,8 +23,12 @@ int main()
     const std::vector<double> bps0 = {4.94, 4.96, 4.98};
     const std::vector<double> bvs0(bps0.size(), 10.0);
     const double decay_coefficient = 0.05;
+    const double tick_size = 0.01;
+
+    // prices are stored in ticks, so the tick size is set before any order is created
+    Bar::SetTickSize(tick_size);
 
-    const LOB lob0(decay_coefficient, aps0, avs0, bps0, bvs0);
+    const Book lob0(decay_coefficient, aps0, avs0, bps0, bvs0);
     const double vol_news = 0.0;
     const double order_arrival_intensity = 40.0;
     double p_otype = 0.7; // prob of getting limit orders (1-u)
@@ -33,13 +40,13 @@ int main()
     const double v_spr = 0.1;
     const double option_pos = 0;
     const double implied_vol = 0.089;
-    const double tick_size = 0.01;
-
-    Bar::SetTickSize(tick_size);
 
-    PathInfo pi_benchmark(T, H, Q, p0, lob0, option_pos, implied_vol);
+    BasicPathInfo<Book> pi_benchmark(T, H, Q, p0, lob0, option_pos, implied_vol);
     RandomInfo ri_benchmark(seed, vol_news, order_arrival_intensity,
                             p_otype, p_info, vol_min, vol_max, m_spr, v_spr, 0.5);
+    // common random numbers: every cell of the phase diagrams meets the same draws in the same orders
+    ri_benchmark.engine = PHILOX_ENGINE;
+    ri_benchmark.substreams = true;
 
     Parameter param1_type = PROB_LIMITORDER;
     const std::vector<double> param1_range = {0.5, 0.55, 0.6, 0.625, 0.65, 0.675, 0.7};
@@ -48,11 +55,11 @@ int main()
     const std::vector<double> param2_range = {-80, -40, 0, 40, 80};
 
     // path info scenarios
-    // std::vector<PathInfo> pi_scenarios;
-    // PathInfo::GenerateScenarios(pi_scenarios, param_type, param_range, pi_benchmark);
+    // std::vector<BasicPathInfo<Book>> pi_scenarios;
+    // BasicPathInfo<Book>::GenerateScenarios(pi_scenarios, param_type, param_range, pi_benchmark);
     // for (auto &pi_scen : pi_scenarios)
     // {
-    //     PathCollection paths(n_samples, pi_scen, ri_benchmark);
+    //     BasicPathCollection<Book> paths(n_samples, pi_scen, ri_benchmark);
     //     paths.GeneratePaths();
     //     paths.PrintSimulationResults();
     // }
@@ -62,23 +69,23 @@ int main()
     // RandomInfo::GenerateScenarios(ri_scenarios, param1_type, param1_range, ri_benchmark);
     // for (auto &ri_scen : ri_scenarios)
     // {
-    //     PathCollection paths(n_samples, pi_benchmark, ri_scen);
+    //     BasicPathCollection<Book> paths(n_samples, pi_benchmark, ri_scen);
     //     paths.GeneratePaths();
     //     paths.PrintSimulationResults();
     // }
 
     // phase diagrams (comparative statics w.r.t. gamma positions and other parameters)
     std::vector<std::vector<double>> res;
-    std::vector<PathInfo> param2_scens;
-    PathInfo::GenerateScenarios(param2_scens, param2_type, param2_range, pi_benchmark);
-    for (PathInfo &p2_sc : param2_scens)
+    std::vector<BasicPathInfo<Book>> param2_scens;
+    BasicPathInfo<Book>::GenerateScenarios(param2_scens, param2_type, param2_range, pi_benchmark);
+    for (BasicPathInfo<Book> &p2_sc : param2_scens)
     {
         std::vector<double> r;
         std::vector<RandomInfo> param1_scens;
         RandomInfo::GenerateScenarios(param1_scens, param1_type, param1_range, ri_benchmark);
         for (RandomInfo &p1_sc : param1_scens)
         {
-            PathCollection paths(n_samples, p2_sc, p1_sc);
+            BasicPathCollection<Book> paths(n_samples, p2_sc, p1_sc);
             paths.GeneratePaths();
             r.push_back(paths.getLiquidityMetrics(0)); // only save the market failure rate
         }
@@ -88,7 +95,7 @@ int main()
     Utils::prettyPrint2DVector(res);
 
     // stationarity analysis
-    // PathCollection paths(n_samples, pi_benchmark, ri_benchmark);
+    // BasicPathCollection<Book> paths(n_samples, pi_benchmark, ri_benchmark);
     // paths.GeneratePaths();
     // paths.PrintSimulationResults();
 
@@ -211,12 +211,45 @@ BOOST_AUTO_TEST_CASE(test_very_small_numbers)
 
 BOOST_AUTO_TEST_SUITE_END()
 
+// without a tick size, prices are kept and compared exactly at any magnitude
+BOOST_AUTO_TEST_SUITE(BarNoTickSizeTests)
+
+BOOST_AUTO_TEST_CASE(test_exact_prices_without_tick_size)
+{
+    BOOST_CHECK(!Bar::HasTickSize());
+    BOOST_CHECK_EQUAL(Bar(5000.0, 1.0).Price(), 5000.0);
+    BOOST_CHECK_EQUAL(Bar(1e10, 1.0).Price(), 1e10);
+    BOOST_CHECK_EQUAL(Bar(1.3, 1.0).Price(), 1.3);
+    BOOST_CHECK_EQUAL(Bar(-4990.5, 1.0).Price(), -4990.5);
+    BOOST_CHECK_EQUAL(Bar(__DBL_MAX__, 1.0).Price(), __DBL_MAX__);
+
+    Bar bar(5001.0, 1.0);
+    BOOST_CHECK(bar.PriceSameAs(5001.0));
+    BOOST_CHECK(bar.PriceHigherThan(5000.0));
+    BOOST_CHECK(bar.PriceLowerThan(5002.0));
+    BOOST_CHECK(!bar.PriceHigherThan(5001.0));
+    BOOST_CHECK(Bar(-2.0, 1.0).PriceLowerThan(-1.0));
+    BOOST_CHECK(Bar(-1.0, 1.0).PriceHigherThan(-2.0));
+    BOOST_CHECK(Bar(-0.5, 1.0).PriceLowerThan(0.5));
+    BOOST_CHECK(theAskBar.PriceHigherThan(1e300));
+    BOOST_CHECK(theBidBar.PriceLowerThan(-1e300));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 // test cases for non-zero tick size should be placed at the end of the tests
 // as set tick_size is not revertible (for safety consideration)
 BOOST_AUTO_TEST_SUITE(BarNonZeroTickSizeTests)
 
 BOOST_AUTO_TEST_CASE(test_nonzero_ticksize)
 {
+    // a bar made without a tick size keeps it from being set
+    {
+        Bar keyed(100.45, 250.0);
+        Bar copy(keyed);
+        BOOST_CHECK_THROW(Bar::SetTickSize(0.1), std::logic_error);
+        BOOST_CHECK(!Bar::HasTickSize());
+    }
     Bar::SetTickSize(0.1);
     Bar bar(100.45, 250.0);
     BOOST_CHECK_CLOSE(bar.Price(), 100.5, EPSILON);
@@ -0,0 +1,101 @@
+// test_decay_kernel.cpp
+#define BOOST_TEST_MODULE DecayKernelTest
+#include <boost/test/included/unit_test.hpp>
+#include <cmath>
+#include <vector>
+#include "../libs/DecayKernel.hpp"
+#include "../libs/Bar.hpp"
+
+BOOST_AUTO_TEST_SUITE(DecayKernelTests)
+
+BOOST_AUTO_TEST_CASE(test_fast_exp_within_tolerance)
+{
+    // decay exponents are -d_coef * (p_mid - p)^2, never positive
+    for (double x = -700.0; x <= 0.0; x += 0.0137)
+        BOOST_CHECK_SMALL(DecayKernel::FastExp(x) / exp(x) - 1.0, DecayKernel::TOLERANCE);
+    for (double x = -1e-6; x <= 1e-6; x += 1.37e-9)
+        BOOST_CHECK_SMALL(DecayKernel::FastExp(x) / exp(x) - 1.0, DecayKernel::TOLERANCE);
+    BOOST_CHECK_EQUAL(DecayKernel::FastExp(0.0), 1.0);
+    BOOST_CHECK_EQUAL(DecayKernel::FastExp(-1000.0), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_apply_matches_scalar)
+{
+    // 13 levels so that the vector loop leaves a tail
+    std::vector<double> ps, vs;
+    for (int i = 0; i < 13; i++)
+    {
+        ps.push_back(95.0 + 0.8 * i);
+        vs.push_back(100.0 + 7.0 * i);
+    }
+    std::vector<double> vs_ref = vs;
+    DecayKernel::Apply(ps.data(), vs.data(), 13, 100.05, 0.1);
+    DecayKernel::ApplyScalar(ps.data(), vs_ref.data(), 13, 100.05, 0.1);
+    for (int i = 0; i < 13; i++)
+        BOOST_CHECK_SMALL(vs[i] - vs_ref[i], vs_ref[i] * DecayKernel::TOLERANCE);
+}
+
+BOOST_AUTO_TEST_CASE(test_apply_far_levels_vanish)
+{
+    std::vector<double> ps = {1.0, 2.0, 3.0, 4.0, 500.0};
+    std::vector<double> vs = {10.0, 10.0, 10.0, 10.0, 10.0};
+    DecayKernel::Apply(ps.data(), vs.data(), 5, 500.0, 100.0);
+    for (int i = 0; i < 4; i++)
+        BOOST_CHECK_SMALL(vs[i], 1e-300);
+    BOOST_CHECK_EQUAL(vs[4], 10.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_factor_matches_apply)
+{
+    std::vector<double> ps = {99.1, 99.7, 100.3, 100.9, 101.5};
+    std::vector<double> vs(5, 1.0);
+    DecayKernel::Apply(ps.data(), vs.data(), 5, 100.0, 0.5);
+    for (int i = 0; i < 5; i++)
+    {
+        double v = 1.0;
+        v += (DecayKernel::Factor(100.0, ps[i], 0.5) - 1) * v;
+        BOOST_CHECK_EQUAL(vs[i], v);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(DecayTableTests)
+
+BOOST_AUTO_TEST_CASE(test_table_needs_tick_size)
+{
+    // tick size has not been set yet
+    DecayTable table(0.5);
+    BOOST_CHECK(!table.Covers(0.5));
+}
+
+BOOST_AUTO_TEST_CASE(test_table_factors)
+{
+    Bar::SetTickSize(0.01);
+    DecayTable table(0.5);
+    BOOST_CHECK(table.Covers(0.5));
+    BOOST_CHECK(!table.Covers(0.4));
+    BOOST_CHECK(!DecayTable(0.0).Covers(0.0));
+
+    BOOST_CHECK_EQUAL(table.Factor(0), 1.0);
+    // k is twice the tick distance, so k = 2 is one tick away; sign does not matter
+    BOOST_CHECK_EQUAL(table.Factor(2), exp(-0.5 * pow(0.01, 2)));
+    BOOST_CHECK_EQUAL(table.Factor(-2), table.Factor(2));
+    for (long long k = 1; k < 3 * DecayTable::MAX_SIZE; k += 997)
+        BOOST_CHECK_CLOSE(table.Factor(k), exp(-0.5 * pow(k * 0.005, 2)), 1e-9);
+
+    // copies share the same factors, which lookups leave untouched
+    DecayTable copy(table);
+    BOOST_CHECK_EQUAL(copy.Factor(12345), table.Factor(12345));
+    const long long size = table.Size();
+    BOOST_CHECK(size > 0 && size <= DecayTable::MAX_SIZE);
+    table.Factor(5 * DecayTable::MAX_SIZE);
+    BOOST_CHECK_EQUAL(table.Size(), size);
+
+    // a steep coefficient stops the table where its factors underflow
+    DecayTable steep(1e4);
+    BOOST_CHECK(steep.Size() < 1000);
+    BOOST_CHECK_EQUAL(steep.Factor(steep.Size() + 10), 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
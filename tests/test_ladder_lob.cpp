@@ -0,0 +1,98 @@
+// test_ladder_lob.cpp
+// the whole LOB test suite is run against LadderLOB, followed by ladder-specific tests
+#include "../libs/LOB.hpp"
+#include "../libs/LadderLOB.hpp"
+#include <random>
+
+#define LOB LadderLOB
+#define CheckedLOB CheckedLadderLOB
+#include "test_lob.cpp"
+#undef CheckedLOB
+#undef LOB
+
+// tick size has been set to 0.1 by the LOB test suite above
+BOOST_AUTO_TEST_SUITE(LadderLOBWindowTests)
+
+BOOST_AUTO_TEST_CASE(test_levels_beyond_window)
+{
+    // 600 is further than PriceLadder::MAX_WINDOW ticks away from 101 and goes to the overflow
+    std::vector<double> ask_prices = {101.0, 600.0, 102.0};
+    std::vector<double> ask_volumes = {100.0, 300.0, 200.0};
+    std::vector<double> bid_prices = {99.0};
+    std::vector<double> bid_volumes = {150.0};
+
+    LadderLOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+
+    BOOST_CHECK_CLOSE(lob.ask(), 101.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getPriceAt(1, -1), 600.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(600.0), 1);
+    BOOST_CHECK_EQUAL(lob.PriceLocation(1, 300.0), 2);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 600.0, EPSILON);
+
+    lob.CancelLimitOrder(1, 600.0, 300.0);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(600.0), 0);
+    BOOST_CHECK_CLOSE(lob.getPriceAt(1, -1), 102.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_window_follows_touch)
+{
+    std::vector<double> ask_prices = {1000.0, 1000.5};
+    std::vector<double> ask_volumes = {100.0, 200.0};
+    std::vector<double> bid_prices = {10.0};
+    std::vector<double> bid_volumes = {150.0};
+
+    LadderLOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+
+    // the new best ask is too far to share the window with the old levels
+    lob.AddLimitOrder(1, 500.0, 50.0);
+    BOOST_CHECK_CLOSE(lob.ask(), 500.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.PriceLocation(1, 1000.2), 2);
+
+    std::vector<Bar> eos;
+    double v = 150.0;
+    lob.AbsorbMarketOrder(eos, v, -1);
+    BOOST_CHECK_EQUAL(eos.size(), 2);
+    BOOST_CHECK_CLOSE(eos[0].Price(), 500.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Price(), 1000.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Volume(), 100.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.ask(), 1000.5, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_same_results_as_lob)
+{
+    std::vector<double> ask_prices = {5.2, 5.4, 5.6};
+    std::vector<double> bid_prices = {4.4, 4.6, 4.8};
+    std::vector<double> volumes(3, 10.0);
+
+    LOB lob(0.05, ask_prices, volumes, bid_prices, volumes);
+    LadderLOB ladder(0.05, ask_prices, volumes, bid_prices, volumes);
+
+    std::default_random_engine generator(2024);
+    std::bernoulli_distribution ber_dist(0.5);
+    std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+    std::normal_distribution<double> norm_dist(-0.3, 0.4);
+    for (int i = 0; i < 2000 && !lob.oneSideEmpty(); i++)
+    {
+        lob.DecayOrders();
+        ladder.DecayOrders();
+        OrderType o_type = ber_dist(generator) ? LIMITORDER : MARKETORDER;
+        int s = ber_dist(generator) ? 1 : -1;
+        double v = uni_dist(generator);
+        double p = lob.mid() - s * norm_dist(generator);
+        std::vector<Bar> eos = lob.AbsorbGeneralOrder(o_type, p, v, s);
+        std::vector<Bar> eos_ladder = ladder.AbsorbGeneralOrder(o_type, p, v, s);
+
+        BOOST_REQUIRE_EQUAL(eos.size(), eos_ladder.size());
+        for (size_t j = 0; j < eos.size(); j++)
+        {
+            BOOST_CHECK_EQUAL(eos[j].Price(), eos_ladder[j].Price());
+            BOOST_CHECK_EQUAL(eos[j].Volume(), eos_ladder[j].Volume());
+        }
+        BOOST_CHECK_EQUAL(lob.bid(), ladder.bid());
+        BOOST_CHECK_EQUAL(lob.ask(), ladder.ask());
+        BOOST_CHECK_EQUAL(lob.getTotalVolume(1), ladder.getTotalVolume(1));
+        BOOST_CHECK_EQUAL(lob.getTotalVolume(-1), ladder.getTotalVolume(-1));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include <boost/test/included/unit_test.hpp>
 #include <vector>
 #include <cmath>
+#include <random>
 #include "../libs/LOB.hpp"
 
 const double EPSILON = 1e-9;
@@ -70,8 +71,7 @@ BOOST_AUTO_TEST_CASE(test_safety_checks)
     std::vector<double> bid_prices; // no bid orders
     std::vector<double> bid_volumes;
 
-    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
-    lob.setSafetyCheck(true);
+    CheckedLOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
 
     BOOST_CHECK_CLOSE(lob.ask(), 101.0, EPSILON);
     BOOST_CHECK_CLOSE(lob.bid(), -__DBL_MAX__, EPSILON);
@@ -288,6 +288,42 @@ BOOST_AUTO_TEST_CASE(test_add_illegal_limit_orders)
     BOOST_CHECK_CLOSE(eos[0].Volume(), 50.0, EPSILON);
 }
 
+BOOST_AUTO_TEST_CASE(test_illegal_limit_order_sweeps_to_limit)
+{
+    std::vector<double> ask_prices = {101.0, 102.0, 103.0, 104.0};
+    std::vector<double> ask_volumes = {100.0, 200.0, 150.0, 50.0};
+    std::vector<double> bid_prices = {99.0, 98.0};
+    std::vector<double> bid_volumes = {150.0, 100.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+
+    // buy 500 up to 103: every crossed level is reported and the rest becomes the best bid
+    std::vector<Bar> eos(2, Bar(1.0, 1.0));
+    double v = 500.0;
+    lob.AbsorbLimitOrder(eos, v, 103.0, -1);
+    BOOST_REQUIRE_EQUAL(eos.size(), 3);
+    BOOST_CHECK_CLOSE(eos[0].Price(), 101.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[0].Volume(), 100.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Price(), 102.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Volume(), 200.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[2].Price(), 103.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[2].Volume(), 150.0, EPSILON);
+    BOOST_CHECK_CLOSE(v, 50.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.bid(), 103.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeAt(-1, -1), 50.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.ask(), 104.0, EPSILON);
+
+    // sell 120 down to 99 stops at the limit without resting anything
+    v = 120.0;
+    lob.AbsorbLimitOrder(eos, v, 99.0, 1);
+    BOOST_REQUIRE_EQUAL(eos.size(), 2);
+    BOOST_CHECK_CLOSE(eos[0].Volume(), -50.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Price(), 99.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos[1].Volume(), -70.0, EPSILON);
+    BOOST_CHECK_SMALL(v, EPSILON);
+    BOOST_CHECK_CLOSE(lob.bid(), 99.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeAt(-1, -1), 80.0, EPSILON);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(LOBCancelLimitOrderTests)
@@ -716,6 +752,62 @@ BOOST_AUTO_TEST_CASE(test_absorb_general_order_other_side_lo_diff_price)
     BOOST_CHECK_CLOSE(lob.ask(), p_new, EPSILON);
 }
 
+BOOST_AUTO_TEST_CASE(test_absorb_general_order_into_buffer_and_sink)
+{
+    std::vector<double> ask_prices = {101.0, 102.0, 103.0};
+    std::vector<double> ask_volumes = {100.0, 200.0, 150.0};
+    std::vector<double> bid_prices = {99.0, 98.0, 97.0};
+    std::vector<double> bid_volumes = {150.0, 100.0, 200.0};
+
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+    LOB lob_buffer(lob), lob_sink(lob);
+
+    std::vector<Bar> eos = lob.AbsorbGeneralOrder(MARKETORDER, 0.0, 250.0, -1);
+    std::vector<Bar> eos_buffer(5, Bar(1.0, 1.0)); // stale content is cleared
+    lob_buffer.AbsorbGeneralOrder(eos_buffer, MARKETORDER, 0.0, 250.0, -1);
+    std::vector<Bar> eos_sink;
+    lob_sink.AbsorbGeneralOrder([&eos_sink](const Bar &eo) { eos_sink.push_back(eo); }, MARKETORDER, 0.0, 250.0, -1);
+
+    BOOST_REQUIRE_EQUAL(eos.size(), 2);
+    BOOST_REQUIRE_EQUAL(eos_buffer.size(), eos.size());
+    BOOST_REQUIRE_EQUAL(eos_sink.size(), eos.size());
+    for (size_t i = 0; i < eos.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(eos_buffer[i].Ticks(), eos[i].Ticks());
+        BOOST_CHECK_EQUAL(eos_buffer[i].Volume(), eos[i].Volume());
+        BOOST_CHECK_EQUAL(eos_sink[i].Ticks(), eos[i].Ticks());
+        BOOST_CHECK_EQUAL(eos_sink[i].Volume(), eos[i].Volume());
+    }
+    BOOST_CHECK_EQUAL(lob_buffer.ask(), lob.ask());
+    BOOST_CHECK_EQUAL(lob_sink.getVolumeAt(1, 0), lob.getVolumeAt(1, 0));
+
+    // reusing the buffer keeps its storage
+    const Bar *data = eos_buffer.data();
+    lob_buffer.AbsorbGeneralOrder(eos_buffer, MARKETORDER, 0.0, 10.0, 1);
+    BOOST_CHECK_EQUAL(eos_buffer.size(), 1);
+    BOOST_CHECK(eos_buffer.data() == data);
+    lob_buffer.AbsorbGeneralOrder(eos_buffer, MARKETORDER, 0.0, 10.0, 0);
+    BOOST_CHECK(eos_buffer.empty());
+
+    // a crossing limit order reaches the sink one fill at a time, each after its level is matched, and rests the rest
+    LOB lob_limit(ask_prices, ask_volumes, bid_prices, bid_volumes);
+    std::vector<double> asks_seen;
+    eos_sink.clear();
+    lob_limit.AbsorbGeneralOrder([&](const Bar &eo)
+                                 {
+                                     eos_sink.push_back(eo);
+                                     asks_seen.push_back(lob_limit.ask());
+                                 },
+                                 LIMITORDER, 102.0, 400.0, -1);
+    BOOST_REQUIRE_EQUAL(eos_sink.size(), 2);
+    BOOST_CHECK_CLOSE(eos_sink[0].Price(), 101.0, EPSILON);
+    BOOST_CHECK_CLOSE(asks_seen[0], 102.0, EPSILON);
+    BOOST_CHECK_CLOSE(eos_sink[1].Volume(), 200.0, EPSILON);
+    BOOST_CHECK_CLOSE(asks_seen[1], 103.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob_limit.bid(), 102.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob_limit.getTotalVolume(-1), 550.0, EPSILON);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 // integrated testing under various scenarios
@@ -793,6 +885,45 @@ BOOST_AUTO_TEST_CASE(test_large_lob_creation)
 
 BOOST_AUTO_TEST_SUITE_END()
 
+// without a tick size, prices of any magnitude are kept exact
+BOOST_AUTO_TEST_SUITE(LOBNoTickSizeTests)
+
+BOOST_AUTO_TEST_CASE(test_large_prices_without_tick_size)
+{
+    std::vector<double> ask_prices = {5000.0, 5001.0};
+    std::vector<double> ask_volumes = {10.0, 20.0};
+    std::vector<double> bid_prices = {4990.0};
+    std::vector<double> bid_volumes = {30.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+
+    BOOST_CHECK_EQUAL(lob.ask(), 5000.0);
+    BOOST_CHECK_EQUAL(lob.bid(), 4990.0);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(5001.0), 1);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(4990.0), -1);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(5000.5), 0);
+
+    // a buy at 5000.5 takes the best ask only and rests the rest as the new best bid
+    std::vector<Bar> eos = lob.AbsorbGeneralOrder(LIMITORDER, 5000.5, 15.0, -1);
+    BOOST_REQUIRE_EQUAL(eos.size(), 1u);
+    BOOST_CHECK_EQUAL(eos[0].Price(), 5000.0);
+    BOOST_CHECK_EQUAL(lob.ask(), 5001.0);
+    BOOST_CHECK_EQUAL(lob.bid(), 5000.5);
+}
+
+#ifndef LOB
+BOOST_AUTO_TEST_CASE(test_tick_features_need_tick_size)
+{
+    LOB lob({1.3, 1.4}, {10.0, 10.0}, {1.2}, {10.0});
+    BOOST_CHECK_EQUAL(lob.ask(), 1.3);
+    BOOST_CHECK_THROW(lob.setDepthProfile(5), std::logic_error);
+    BOOST_CHECK_THROW(lob.getDepth(1, 2), std::logic_error);
+    BOOST_CHECK_THROW(lob.setPruning(0.0, 3), std::logic_error);
+    lob.setPruning(0.01); // dust alone needs no ticks
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
+
 // test cases for non-zero tick size should be placed at the end of the tests
 // as set tick_size is not revertible (for safety consideration)
 BOOST_AUTO_TEST_SUITE(LOBNonZeroTickSizeTests)
@@ -800,6 +931,12 @@ BOOST_AUTO_TEST_SUITE(LOBNonZeroTickSizeTests)
 BOOST_AUTO_TEST_CASE(test_nonzero_ticksize_contains_price)
 {
     const double ts = 0.1;
+    // a book made without a tick size keeps it from being set
+    {
+        std::vector<double> prices = {101.0}, volumes = {100.0};
+        LOB keyed(prices, volumes, prices, volumes);
+        BOOST_CHECK_THROW(Bar::SetTickSize(ts), std::logic_error);
+    }
     Bar::SetTickSize(ts);
 
     std::vector<double> ask_prices = {101.0, 102.0};
@@ -877,3 +1014,819 @@ BOOST_AUTO_TEST_CASE(test_nonzero_ticksize_absorb_limit_order)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBTotalVolumeTests)
+
+// total volume and level count recounted from the bars
+void CheckTotals(const LOB &lob)
+{
+    for (int s = -1; s <= 1; s += 2)
+    {
+        double volume = 0.0;
+        for (int i = 0; i < lob.getNumLevels(s); i++)
+            volume += lob.getVolumeAt(s, i);
+        BOOST_CHECK_SMALL(lob.getTotalVolume(s) - volume, 1e-9);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_totals_follow_every_order)
+{
+    std::vector<double> ask_prices = {101.0, 102.0, 103.0};
+    std::vector<double> ask_volumes = {100.0, 200.0, 150.0};
+    std::vector<double> bid_prices = {99.0, 98.0, 97.0};
+    std::vector<double> bid_volumes = {150.0, 100.0, 200.0};
+    LOB lob(0.05, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    BOOST_CHECK_EQUAL(lob.getNumLevels(1), 3);
+    BOOST_CHECK_EQUAL(lob.getNumLevels(0), 0);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 450.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(-1), 450.0, EPSILON);
+
+    std::vector<Bar> eos;
+    double v = 0.0;
+    lob.AddLimitOrder(1, 100.0, 30.0);
+    lob.AddLimitOrder(1, 102.0, 20.0);
+    BOOST_CHECK_EQUAL(lob.getNumLevels(1), 4);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 500.0, EPSILON);
+    lob.AddLimitOrder(-1, 100.0, 10.0); // executes against the ask at 100
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 490.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(-1), 450.0, EPSILON);
+    lob.CancelLimitOrder(1, 103.0, 50.0);
+    lob.CancelLimitOrder(-1, 97.0, 500.0); // more than the bar holds
+    BOOST_CHECK_EQUAL(lob.getNumLevels(-1), 2);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 440.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(-1), 250.0, EPSILON);
+    v = 60.0;
+    lob.AbsorbMarketOrder(eos, v, 1);
+    v = 60.0;
+    lob.AbsorbLimitOrder(eos, v, 102.0, -1);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 380.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(-1), 190.0, EPSILON);
+    CheckTotals(lob);
+
+    lob.DecayOrders();
+    BOOST_CHECK(lob.getTotalVolume(1) < 380.0);
+    CheckTotals(lob);
+}
+
+BOOST_AUTO_TEST_CASE(test_totals_under_random_flow)
+{
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 40; i++)
+    {
+        ask_prices.push_back(100.5 + 0.5 * i);
+        bid_prices.push_back(99.5 - 0.5 * i);
+        volumes.push_back(10.0);
+    }
+    LOB lob(0.01, ask_prices, volumes, bid_prices, volumes);
+    std::default_random_engine generator(7);
+    std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+    std::normal_distribution<double> norm_dist(0.0, 2.0);
+    std::vector<Bar> eos;
+    for (int i = 0; i < 500 && !lob.oneSideEmpty(); i++)
+    {
+        int s = uni_dist(generator) < 0.5 ? 1 : -1;
+        double v = 20.0 * uni_dist(generator);
+        double p = lob.mid() + s * norm_dist(generator);
+        double u = uni_dist(generator);
+        if (u < 0.2)
+            lob.DecayOrders();
+        else if (u < 0.4)
+            lob.CancelLimitOrder(s, lob.getPriceAt(s, 0), v);
+        else if (u < 0.6)
+            lob.AbsorbMarketOrder(eos, v, s);
+        else
+            lob.AbsorbLimitOrder(eos, v, p, s);
+        CheckTotals(lob);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// tests of LOB-only features, skipped when this file is run against LadderLOB
+#ifndef LOB
+BOOST_AUTO_TEST_SUITE(LOBLazyDecayTests)
+
+BOOST_AUTO_TEST_CASE(test_lazy_decay_matches_eager)
+{
+    std::vector<double> ask_prices = {100.5, 101.0, 103.0};
+    std::vector<double> ask_volumes = {100.0, 200.0, 300.0};
+    std::vector<double> bid_prices = {97.0, 99.0, 99.5};
+    std::vector<double> bid_volumes = {300.0, 200.0, 100.0};
+
+    LOB eager(0.05, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    LOB lazy(0.05, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lazy.setLazyDecay(true);
+
+    for (int i = 0; i < 10; i++)
+    {
+        eager.DecayOrders();
+        lazy.DecayOrders();
+        // moves the mid, so that later epochs decay with a different mid
+        if (i == 4)
+        {
+            eager.AddLimitOrder(1, 100.0, 50.0);
+            lazy.AddLimitOrder(1, 100.0, 50.0);
+        }
+    }
+    // best levels are settled by reads, deeper ones by getTotalVolume
+    BOOST_CHECK_CLOSE(lazy.Ask().Volume(), eager.Ask().Volume(), EPSILON);
+    BOOST_CHECK_CLOSE(lazy.getVolumeAt(-1, 0), eager.getVolumeAt(-1, 0), EPSILON);
+    BOOST_CHECK_CLOSE(lazy.getTotalVolume(1), eager.getTotalVolume(1), EPSILON);
+    BOOST_CHECK_CLOSE(lazy.getTotalVolume(-1), eager.getTotalVolume(-1), EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_lazy_decay_settles_before_matching)
+{
+    std::vector<double> ask_prices = {101.0, 102.0};
+    std::vector<double> ask_volumes = {100.0, 100.0};
+    std::vector<double> bid_prices = {99.0};
+    std::vector<double> bid_volumes = {100.0};
+
+    LOB eager(0.1, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    LOB lazy(0.1, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lazy.setLazyDecay(true);
+    for (int i = 0; i < 3; i++)
+    {
+        eager.DecayOrders();
+        lazy.DecayOrders();
+    }
+
+    std::vector<Bar> eos, eos_lazy;
+    double v = 150.0, v_lazy = 150.0;
+    eager.AbsorbMarketOrder(eos, v, -1);
+    lazy.AbsorbMarketOrder(eos_lazy, v_lazy, -1);
+    BOOST_REQUIRE_EQUAL(eos_lazy.size(), eos.size());
+    for (size_t i = 0; i < eos.size(); i++)
+        BOOST_CHECK_CLOSE(eos_lazy[i].Volume(), eos[i].Volume(), EPSILON);
+    BOOST_CHECK_CLOSE(v_lazy, v, EPSILON);
+
+    // a cancel settles the bar before taking volume off it
+    eager.CancelLimitOrder(-1, 99.0, 10.0);
+    lazy.CancelLimitOrder(-1, 99.0, 10.0);
+    BOOST_CHECK_CLOSE(lazy.Bid().Volume(), eager.Bid().Volume(), EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_materialize_keeps_volumes)
+{
+    std::vector<double> ask_prices = {101.0, 102.0};
+    std::vector<double> ask_volumes = {100.0, 100.0};
+    std::vector<double> bid_prices = {98.0, 99.0};
+    std::vector<double> bid_volumes = {100.0, 100.0};
+
+    LOB lazy(0.1, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lazy.setLazyDecay(true);
+    lazy.DecayOrders();
+    lazy.DecayOrders();
+    LOB copy(lazy);
+    lazy.Materialize();
+    for (int s = -1; s <= 1; s += 2)
+        for (int i = 0; i < 2; i++)
+            BOOST_CHECK_CLOSE(lazy.getVolumeAt(s, i), copy.getVolumeAt(s, i), EPSILON);
+
+    // levels added after materialising decay only from then on
+    lazy.AddLimitOrder(1, 103.0, 100.0);
+    lazy.DecayOrders();
+    BOOST_CHECK_CLOSE(lazy.getVolumeAt(1, -1), 100.0 * exp(-0.1 * pow(100.0 - 103.0, 2)), EPSILON);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBSnapshotTests)
+
+// snapshots share level chunks with the book they were copied from; writing to either must not leak into the other
+void CheckSnapshotsKeepValues(bool lazy)
+{
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 100; i++)
+    {
+        ask_prices.push_back(100.5 + 0.5 * i);
+        bid_prices.push_back(99.5 - 0.5 * i);
+        volumes.push_back(10.0 + i);
+    }
+    LOB lob(0.0001, ask_prices, volumes, bid_prices, volumes);
+    lob.setLazyDecay(lazy);
+
+    std::vector<LOB> snapshots;
+    std::vector<std::vector<double>> recorded;
+    for (int i = 0; i < 60; i++)
+    {
+        lob.DecayOrders();
+        int s = i % 2 ? 1 : -1;
+        switch (i % 3)
+        {
+        case 0: // new level deep in the book, splitting a chunk
+            lob.AddLimitOrder(s, 100.0 + s * (20.25 + 0.5 * (i % 7)), 5.0);
+            break;
+        case 1:
+            lob.CancelLimitOrder(s, 100.0 + s * (10.5 + 0.5 * (i % 5)), 1000.0);
+            break;
+        default:
+            lob.AbsorbGeneralOrder(MARKETORDER, 0.0, 15.0, s);
+            break;
+        }
+        snapshots.push_back(lob);
+        recorded.push_back({lob.getTotalVolume(1), lob.getTotalVolume(-1), lob.ask(), lob.bid(),
+                            lob.getVolumeAt(1, 20), lob.getVolumeAt(-1, -20)});
+    }
+    for (size_t i = 0; i < snapshots.size(); i++)
+    {
+        const LOB &snap = snapshots[i];
+        BOOST_CHECK_CLOSE(snap.getTotalVolume(1), recorded[i][0], EPSILON);
+        BOOST_CHECK_CLOSE(snap.getTotalVolume(-1), recorded[i][1], EPSILON);
+        BOOST_CHECK_EQUAL(snap.ask(), recorded[i][2]);
+        BOOST_CHECK_EQUAL(snap.bid(), recorded[i][3]);
+        BOOST_CHECK_CLOSE(snap.getVolumeAt(1, 20), recorded[i][4], EPSILON);
+        BOOST_CHECK_CLOSE(snap.getVolumeAt(-1, -20), recorded[i][5], EPSILON);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_snapshots_keep_values)
+{
+    CheckSnapshotsKeepValues(false);
+}
+
+BOOST_AUTO_TEST_CASE(test_lazy_snapshots_keep_values)
+{
+    CheckSnapshotsKeepValues(true);
+}
+
+BOOST_AUTO_TEST_CASE(test_copy_is_independent)
+{
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 70; i++)
+    {
+        ask_prices.push_back(101.0 + i);
+        bid_prices.push_back(99.0 - i);
+        volumes.push_back(100.0);
+    }
+    LOB lob(ask_prices, volumes, bid_prices, volumes);
+    LOB copy(lob);
+    copy.CancelLimitOrder(1, 150.0, 100.0);
+    copy.AddLimitOrder(-1, 50.5, 30.0);
+    lob.AddLimitOrder(1, 150.5, 20.0);
+
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(150.0), 1);
+    BOOST_CHECK_EQUAL(copy.ContainsPrice(150.0), 0);
+    BOOST_CHECK_EQUAL(lob.ContainsPrice(50.5), 0);
+    BOOST_CHECK_EQUAL(copy.ContainsPrice(50.5), -1);
+    BOOST_CHECK_EQUAL(copy.ContainsPrice(150.5), 0);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 7020.0, EPSILON);
+    BOOST_CHECK_CLOSE(copy.getTotalVolume(1), 6900.0, EPSILON);
+    BOOST_CHECK_CLOSE(copy.getTotalVolume(-1), 7030.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.PriceLocation(1, 151.0), 51);
+    BOOST_CHECK_EQUAL(copy.PriceLocation(1, 151.0), 49);
+}
+
+BOOST_AUTO_TEST_CASE(test_decay_writes_to_the_copy_alone)
+{
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 70; i++)
+    {
+        ask_prices.push_back(101.0 + i);
+        bid_prices.push_back(99.0 - i);
+        volumes.push_back(100.0);
+    }
+    // no decay at all leaves the chunks shared
+    {
+        LOB lob(0.0, ask_prices, volumes, bid_prices, volumes);
+        LOB copy(lob);
+        const int chunks = lob.getSharedChunks(1, lob);
+        BOOST_REQUIRE(chunks > 1);
+        copy.DecayOrders();
+        BOOST_CHECK_EQUAL(copy.getSharedChunks(1, lob), chunks);
+        BOOST_CHECK_EQUAL(copy.getSharedChunks(-1, lob), lob.getSharedChunks(-1, lob));
+        BOOST_CHECK_CLOSE(copy.getTotalVolume(1), 7000.0, EPSILON);
+    }
+
+    // a decay that changes volumes writes to the copy alone
+    LOB lob(0.01, ask_prices, volumes, bid_prices, volumes);
+    LOB copy(lob);
+    copy.DecayOrders();
+    BOOST_CHECK_EQUAL(copy.getSharedChunks(1, lob), 0);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 7000.0, EPSILON);
+    BOOST_CHECK(copy.getTotalVolume(1) < 7000.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_queries_leave_shared_chunks_alone)
+{
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 70; i++)
+    {
+        ask_prices.push_back(101.0 + i);
+        bid_prices.push_back(99.0 - i);
+        volumes.push_back(100.0);
+    }
+    LOB lob(ask_prices, volumes, bid_prices, volumes);
+    LOB copy(lob);
+    const int chunks = lob.getSharedChunks(1, lob);
+
+    // each copy caches the totals of the chunks it walks for itself, so queries share chunks safely
+    double v_exe = 0.0;
+    const double vwap = lob.getMarketOrderVWAP(-1, 5000.0, v_exe);
+    BOOST_CHECK_CLOSE(copy.getMarketOrderVWAP(-1, 5000.0, v_exe), vwap, EPSILON);
+    BOOST_CHECK_EQUAL(copy.getSharedChunks(1, lob), chunks);
+
+    // a write to one copy leaves the totals the other has cached as they were
+    copy.AddLimitOrder(1, 101.0, 100.0);
+    BOOST_CHECK(copy.getMarketOrderVWAP(-1, 5000.0, v_exe) < vwap);
+    BOOST_CHECK_CLOSE(lob.getMarketOrderVWAP(-1, 5000.0, v_exe), vwap, EPSILON);
+    BOOST_CHECK_CLOSE(copy.getVolumeUpTo(-1, 110.0), 1100.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeUpTo(-1, 110.0), 1000.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBBatchTests)
+
+struct BatchFixture
+{
+    BatchFixture()
+    {
+        std::vector<double> ask_prices, bid_prices, volumes;
+        for (int i = 0; i < 10; i++)
+        {
+            ask_prices.push_back(101.0 + i);
+            bid_prices.push_back(99.0 - i);
+            volumes.push_back(100.0);
+        }
+        lob = LOB(0.01, ask_prices, volumes, bid_prices, volumes);
+        checked = CheckedLOB(0.01, ask_prices, volumes, bid_prices, volumes);
+        orders = {{MARKETORDER, 0.0, 150.0, -1},
+                  {LIMITORDER, 100.5, 40.0, 1},
+                  {LIMITORDER, 103.0, 80.0, -1},
+                  {MARKETORDER, 0.0, 30.0, 1},
+                  {LIMITORDER, 100.0, 0.0, 0}};
+    }
+    LOB lob;
+    CheckedLOB checked;
+    std::vector<Order> orders;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_batch_matches_single_orders, BatchFixture)
+{
+    LOB single(lob);
+    std::vector<double> mids;
+    std::vector<std::vector<Bar>> eos;
+    for (const Order &o : orders)
+    {
+        single.DecayOrders();
+        eos.push_back(single.AbsorbGeneralOrder(o.type, o.p, o.v, o.s));
+        mids.push_back(single.mid());
+    }
+
+    std::vector<double> mids_batch(1, 0.0); // outputs are appended to
+    std::vector<Bar> eos_batch;
+    std::vector<int> eo_ends;
+    lob.AbsorbOrders(orders.data(), static_cast<int>(orders.size()), mids_batch, eos_batch, eo_ends);
+
+    BOOST_REQUIRE_EQUAL(mids_batch.size(), orders.size() + 1);
+    BOOST_REQUIRE_EQUAL(eo_ends.size(), orders.size());
+    BOOST_CHECK_EQUAL(eo_ends.back(), eos_batch.size());
+    int begin = 0;
+    for (size_t i = 0; i < orders.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(mids_batch[i + 1], mids[i]);
+        BOOST_REQUIRE_EQUAL(eo_ends[i] - begin, eos[i].size());
+        for (int j = begin; j < eo_ends[i]; j++)
+        {
+            BOOST_CHECK_EQUAL(eos_batch[j].Ticks(), eos[i][j - begin].Ticks());
+            BOOST_CHECK_EQUAL(eos_batch[j].Volume(), eos[i][j - begin].Volume());
+        }
+        begin = eo_ends[i];
+    }
+    BOOST_CHECK_EQUAL(eo_ends[0], 2);
+    BOOST_CHECK_EQUAL(lob.getTotalVolume(1), single.getTotalVolume(1));
+    BOOST_CHECK_EQUAL(lob.getTotalVolume(-1), single.getTotalVolume(-1));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_batch_generator_sees_mid, BatchFixture)
+{
+    LOB pregenerated(lob);
+    std::vector<double> mids, mids_gen, seen;
+    std::vector<Bar> eos, eos_gen;
+    std::vector<int> eo_ends, eo_ends_gen;
+    pregenerated.AbsorbOrders(orders.data(), static_cast<int>(orders.size()), mids, eos, eo_ends);
+
+    size_t i = 0;
+    lob.AbsorbOrderFlow([&](Order &o, double p_mid)
+                        { seen.push_back(p_mid); o = orders[i++]; },
+                        static_cast<int>(orders.size()), mids_gen, eos_gen, eo_ends_gen);
+
+    BOOST_CHECK_EQUAL(seen[0], 100.0);
+    for (size_t k = 1; k < orders.size(); k++)
+        BOOST_CHECK_EQUAL(seen[k], mids_gen[k - 1]);
+    BOOST_CHECK(mids_gen == mids);
+    BOOST_CHECK(eo_ends_gen == eo_ends);
+    BOOST_CHECK_EQUAL(eos_gen.size(), eos.size());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_batch_stops_on_market_failure, BatchFixture)
+{
+    std::vector<double> mids;
+    std::vector<Bar> eos;
+    std::vector<int> eo_ends;
+    Order sweep = {MARKETORDER, 0.0, 2000.0, -1};
+    Order more = {MARKETORDER, 0.0, 10.0, -1};
+    std::vector<Order> run = {sweep, more};
+    LOB fresh(lob);
+    BOOST_CHECK_THROW(checked.AbsorbOrders(run.data(), 2, mids, eos, eo_ends), std::out_of_range);
+    BOOST_CHECK_EQUAL(mids.size(), 0);
+    BOOST_CHECK_EQUAL(eos.size(), 10);
+    BOOST_CHECK_EQUAL(eo_ends.size(), 1);
+
+    // without checks the run stops at the order that empties a side, which gets no mid
+    eos.resize(0);
+    eo_ends.resize(0);
+    BOOST_CHECK_EQUAL(lob.AbsorbOrders(run.data(), 2, mids, eos, eo_ends), 1);
+    BOOST_CHECK_EQUAL(mids.size(), 0);
+    BOOST_CHECK_EQUAL(eos.size(), 10);
+    BOOST_CHECK_EQUAL(eo_ends.size(), 1);
+    BOOST_CHECK(lob.oneSideEmpty());
+
+    // generated flow stops there as well, and draws nothing once the book starts with a side empty
+    int n_drawn = 0;
+    int n_run = fresh.AbsorbOrderFlow([&](Order &o, double)
+                                      { o = run[std::min(n_drawn++, 1)]; },
+                                      5, mids, eos, eo_ends);
+    BOOST_CHECK_EQUAL(n_run, 1);
+    BOOST_CHECK_EQUAL(n_drawn, 1);
+    BOOST_CHECK_EQUAL(mids.size(), 0);
+    n_run = fresh.AbsorbOrderFlow([&](Order &o, double)
+                                  { o = run[std::min(n_drawn++, 1)]; },
+                                  5, mids, eos, eo_ends);
+    BOOST_CHECK_EQUAL(n_run, 0);
+    BOOST_CHECK_EQUAL(n_drawn, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// tick size has been set to 0.1 above
+BOOST_AUTO_TEST_SUITE(LOBDepthTests)
+
+BOOST_AUTO_TEST_CASE(test_depth_profile)
+{
+    std::vector<double> ask_prices = {100.1, 100.2, 100.4, 100.8};
+    std::vector<double> ask_volumes = {10.0, 20.0, 30.0, 40.0};
+    std::vector<double> bid_prices = {99.9, 99.7};
+    std::vector<double> bid_volumes = {15.0, 25.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+    // the same answers without a profile
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 1), 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 4), 60.0, EPSILON);
+
+    lob.setDepthProfile(5);
+    BOOST_CHECK_EQUAL(lob.getDepth(0, 3), 0.0);
+    BOOST_CHECK_EQUAL(lob.getDepth(1, 0), 0.0);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 1), 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 2), 30.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 3), 30.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 4), 60.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 5), 60.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 8), 100.0, EPSILON); // beyond the profile
+    BOOST_CHECK_CLOSE(lob.getDepth(-1, 3), 40.0, EPSILON);
+
+    // behind the best price the profile is shifted in place
+    lob.AddLimitOrder(1, 100.3, 5.0);
+    lob.CancelLimitOrder(1, 100.2, 20.0);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 2), 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 3), 15.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 5), 45.0, EPSILON);
+
+    // a new best price moves every distance
+    lob.AddLimitOrder(1, 100.0, 1.0);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 1), 1.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 5), 46.0, EPSILON);
+    std::vector<Bar> eos;
+    double v = 6.0;
+    lob.AbsorbMarketOrder(eos, v, -1);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 1), 5.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getDepth(1, 4), 40.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_depth_profile_matches_scan)
+{
+    for (int lazy = 0; lazy < 2; lazy++)
+    {
+        std::vector<double> ask_prices, bid_prices, volumes;
+        for (int i = 0; i < 40; i++)
+        {
+            ask_prices.push_back(100.1 + 0.1 * i);
+            bid_prices.push_back(99.9 - 0.1 * i);
+            volumes.push_back(10.0);
+        }
+        LOB lob(0.01, ask_prices, volumes, bid_prices, volumes);
+        lob.setLazyDecay(lazy);
+        lob.setDepthProfile(10);
+        std::default_random_engine generator(11);
+        std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+        std::normal_distribution<double> norm_dist(0.0, 0.5);
+        std::vector<Bar> eos;
+        for (int i = 0; i < 400 && !lob.oneSideEmpty(); i++)
+        {
+            int s = uni_dist(generator) < 0.5 ? 1 : -1;
+            double v = 15.0 * uni_dist(generator);
+            double p = lob.mid() + s * norm_dist(generator);
+            double u = uni_dist(generator);
+            if (u < 0.2)
+                lob.DecayOrders();
+            else if (u < 0.4)
+                lob.CancelLimitOrder(s, lob.getPriceAt(s, s > 0 ? 1 : -2), v);
+            else if (u < 0.5)
+                lob.AbsorbMarketOrder(eos, v, s);
+            else
+                lob.AbsorbLimitOrder(eos, v, p, s);
+
+            LOB scan(lob);
+            scan.setDepthProfile(0);
+            for (int k = 1; k <= 10; k += 3)
+            {
+                BOOST_CHECK_SMALL(lob.getDepth(1, k) - scan.getDepth(1, k), 1e-9);
+                BOOST_CHECK_SMALL(lob.getDepth(-1, k) - scan.getDepth(-1, k), 1e-9);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_decay_keeps_depth_profile_current)
+{
+    for (int lazy = 0; lazy < 2; lazy++)
+    {
+        std::vector<double> ask_prices, bid_prices, volumes;
+        for (int i = 0; i < 20; i++)
+        {
+            ask_prices.push_back(100.1 + 0.1 * i);
+            bid_prices.push_back(99.9 - 0.1 * i);
+            volumes.push_back(10.0);
+        }
+        LOB lob(0.5, ask_prices, volumes, bid_prices, volumes);
+        lob.setLazyDecay(lazy);
+        if (!lazy)
+            lob.setPruning(9.0, 0);
+        lob.setDepthProfile(10);
+        lob.getDepth(1, 10);
+        lob.getDepth(-1, 10);
+        for (int i = 0; i < 5; i++)
+        {
+            lob.DecayOrders();
+            // decay scales the profile in place rather than leaving it to be rebuilt by the next query
+            BOOST_CHECK(lob.hasCurrentDepth(1));
+            BOOST_CHECK(lob.hasCurrentDepth(-1));
+            LOB scan(lob);
+            scan.setDepthProfile(0);
+            for (int k = 1; k <= 10; k++)
+            {
+                BOOST_CHECK_SMALL(lob.getDepth(1, k) - scan.getDepth(1, k), 1e-9);
+                BOOST_CHECK_SMALL(lob.getDepth(-1, k) - scan.getDepth(-1, k), 1e-9);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBPriceImpactTests)
+
+BOOST_AUTO_TEST_CASE(test_vwap_for_volume)
+{
+    std::vector<double> ask_prices = {101.0, 102.0, 103.0};
+    std::vector<double> ask_volumes = {100.0, 200.0, 150.0};
+    std::vector<double> bid_prices = {99.0, 98.0};
+    std::vector<double> bid_volumes = {150.0, 100.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+
+    double v_exe = 0.0;
+    BOOST_CHECK_CLOSE(lob.getMarketOrderVWAP(-1, 50.0, v_exe), 101.0, EPSILON);
+    BOOST_CHECK_CLOSE(v_exe, 50.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getMarketOrderVWAP(-1, 200.0, v_exe), 101.5, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getMarketOrderVWAP(1, 1000.0, v_exe), 98.6, EPSILON);
+    BOOST_CHECK_CLOSE(v_exe, 250.0, EPSILON); // the bids run out
+    BOOST_CHECK_THROW(lob.getMarketOrderVWAP(0, 10.0, v_exe), std::invalid_argument);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 450.0, EPSILON); // the book is untouched
+
+    BOOST_CHECK_CLOSE(lob.getVolumeUpTo(-1, 102.0), 300.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeUpTo(-1, 102.5), 300.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.getVolumeUpTo(-1, 100.0), 0.0);
+    BOOST_CHECK_CLOSE(lob.getVolumeUpTo(1, 98.0), 250.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeUpTo(1, 99.0), 150.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_vwap_matches_market_order)
+{
+    for (int lazy = 0; lazy < 2; lazy++)
+    {
+        // deep enough for several chunks per side
+        std::vector<double> ask_prices, bid_prices, volumes;
+        for (int i = 0; i < 150; i++)
+        {
+            ask_prices.push_back(100.1 + 0.1 * i);
+            bid_prices.push_back(99.9 - 0.1 * i);
+            volumes.push_back(10.0 + i % 7);
+        }
+        LOB lob(0.01, ask_prices, volumes, bid_prices, volumes);
+        lob.setLazyDecay(lazy);
+        std::default_random_engine generator(5);
+        std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+        std::normal_distribution<double> norm_dist(0.0, 1.0);
+        std::vector<Bar> eos;
+        for (int i = 0; i < 200; i++)
+        {
+            int s = uni_dist(generator) < 0.5 ? 1 : -1;
+            double p = lob.mid() + s * norm_dist(generator);
+            double v = 20.0 * uni_dist(generator);
+            lob.DecayOrders();
+            lob.AbsorbLimitOrder(eos, v, p, s);
+
+            double v_mo = 2000.0 * uni_dist(generator);
+            double v_exe = 0.0;
+            double vwap = lob.getMarketOrderVWAP(s, v_mo, v_exe);
+            LOB copy(lob);
+            double v_left = v_mo;
+            BOOST_CHECK_CLOSE(vwap, copy.AbsorbMarketOrder(eos, v_left, s), EPSILON);
+            BOOST_CHECK_SMALL(v_exe - (v_mo - v_left), 1e-9);
+
+            double p_limit = lob.mid() - s * 5.0 * uni_dist(generator);
+            double volume = 0.0;
+            for (int k = 0; k < lob.getNumLevels(-s); k++)
+                if (s > 0 ? lob.getPriceAt(-s, k) >= p_limit : lob.getPriceAt(-s, k) <= p_limit)
+                    volume += lob.getVolumeAt(-s, k);
+            BOOST_CHECK_CLOSE(lob.getVolumeUpTo(s, p_limit), volume, EPSILON);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBOrderQueueTests)
+
+BOOST_AUTO_TEST_CASE(test_orders_fill_in_time_priority)
+{
+    std::vector<double> ask_prices = {100.1, 100.2};
+    std::vector<double> ask_volumes = {40.0, 20.0};
+    std::vector<double> bid_prices = {99.9};
+    std::vector<double> bid_volumes = {30.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lob.setOrderQueues(true, 16);
+    std::vector<Bar> eos;
+
+    // handles come back only with queues on and for volume left resting
+    double v = 10.0;
+    OrderHandle a = lob.PostLimitOrder(eos, v, 100.1, 1);
+    v = 30.0;
+    OrderHandle b = lob.PostLimitOrder(eos, v, 100.1, 1);
+    BOOST_CHECK(a.IsValid() && b.IsValid());
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(a), 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeAhead(a), 40.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeAhead(b), 50.0, EPSILON);
+
+    // executions take the volume that was there first, then a, then b
+    v = 45.0;
+    lob.AbsorbMarketOrder(eos, v, -1);
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(a), 5.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.getVolumeAhead(a), 0.0);
+    BOOST_CHECK_CLOSE(lob.getVolumeAhead(b), 5.0, EPSILON);
+
+    // anonymous cancels come off the back of the queue
+    lob.CancelLimitOrder(1, 100.1, 10.0);
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(a), 5.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(b), 20.0, EPSILON);
+
+    lob.CancelOrder(a);
+    BOOST_CHECK_EQUAL(lob.getOrderVolume(a), 0.0);
+    BOOST_CHECK_CLOSE(lob.getVolumeAt(1, 0), 20.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 40.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.getVolumeAhead(b), 0.0);
+    lob.CancelOrder(a); // cancelling twice does nothing
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 40.0, EPSILON);
+
+    // cancelling the last order at a level takes the level out
+    lob.CancelOrder(b);
+    BOOST_CHECK_CLOSE(lob.ask(), 100.2, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), 20.0, EPSILON);
+
+    // a crossing order rests only what it could not execute
+    v = 50.0;
+    OrderHandle c = lob.PostLimitOrder(eos, v, 99.9, 1);
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(c), 20.0, EPSILON);
+    v = 5.0;
+    OrderHandle d = lob.PostLimitOrder(eos, v, 100.0, -1);
+    BOOST_CHECK(!d.IsValid());
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(c), 15.0, EPSILON);
+
+    lob.setOrderQueues(false);
+    BOOST_CHECK_EQUAL(lob.getOrderVolume(c), 0.0);
+    v = 5.0;
+    BOOST_CHECK(!lob.PostLimitOrder(eos, v, 100.5, 1).IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(test_copies_keep_their_own_queues)
+{
+    std::vector<double> ask_prices = {100.1, 100.2};
+    std::vector<double> ask_volumes = {40.0, 20.0};
+    std::vector<double> bid_prices = {99.9};
+    std::vector<double> bid_volumes = {30.0};
+    LOB lob(ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lob.setOrderQueues(true);
+    std::vector<Bar> eos;
+    double v = 10.0;
+    OrderHandle a = lob.PostLimitOrder(eos, v, 100.1, 1);
+
+    // a copy shares the queues until one of the books changes them
+    LOB copy(lob);
+    v = 45.0;
+    copy.AbsorbMarketOrder(eos, v, -1);
+    copy.CancelOrder(a);
+    BOOST_CHECK_EQUAL(copy.getOrderVolume(a), 0.0);
+    BOOST_CHECK_CLOSE(lob.getOrderVolume(a), 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getVolumeAhead(a), 40.0, EPSILON);
+    v = 5.0;
+    lob.PostLimitOrder(eos, v, 100.1, 1);
+    BOOST_CHECK_CLOSE(lob.getVolumeAhead(a), 40.0, EPSILON);
+    BOOST_CHECK_EQUAL(copy.getOrderVolume(a), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_orders_keep_their_share_through_decay)
+{
+    for (int lazy = 0; lazy < 2; lazy++)
+    {
+        std::vector<double> ask_prices = {100.1, 100.3};
+        std::vector<double> ask_volumes = {10.0, 20.0};
+        std::vector<double> bid_prices = {99.9, 99.7};
+        std::vector<double> bid_volumes = {10.0, 20.0};
+        LOB lob(0.05, ask_prices, ask_volumes, bid_prices, bid_volumes);
+        lob.setLazyDecay(lazy);
+        lob.setOrderQueues(true);
+        std::vector<Bar> eos;
+        double v = 30.0;
+        OrderHandle h = lob.PostLimitOrder(eos, v, 100.3, 1);
+        for (int i = 0; i < 5; i++)
+            lob.DecayOrders();
+        const double level = lob.getVolumeAt(1, 1);
+        BOOST_CHECK(level < 50.0);
+        BOOST_CHECK_CLOSE(lob.getOrderVolume(h), 0.6 * level, EPSILON);
+        BOOST_CHECK_CLOSE(lob.getVolumeAhead(h), 0.4 * level, EPSILON);
+        lob.CancelOrder(h);
+        BOOST_CHECK_CLOSE(lob.getVolumeAt(1, 1), 0.4 * level, EPSILON);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LOBPruningTests)
+
+BOOST_AUTO_TEST_CASE(test_prune_beyond_depth)
+{
+    // deep enough for several chunks per side
+    std::vector<double> ask_prices, bid_prices, volumes;
+    for (int i = 0; i < 100; i++)
+    {
+        ask_prices.push_back(100.1 + 0.1 * i);
+        bid_prices.push_back(99.9 - 0.1 * i);
+        volumes.push_back(10.0);
+    }
+    LOB lob(0.01, ask_prices, volumes, bid_prices, volumes);
+    LOB unpruned(lob);
+    lob.setPruning(0.0, 3);
+    lob.DecayOrders();
+    unpruned.DecayOrders();
+
+    // the mid is at 100.0: 100.1 to 100.3 and 99.7 to 99.9 are within 3 ticks
+    BOOST_CHECK_EQUAL(lob.getNumLevels(1), 3);
+    BOOST_CHECK_EQUAL(lob.getNumLevels(-1), 3);
+    BOOST_CHECK_CLOSE(lob.getPriceAt(1, -1), 100.3, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getPriceAt(-1, 0), 99.7, EPSILON);
+    double volume = 0.0;
+    for (int k = 0; k < 3; k++)
+    {
+        BOOST_CHECK_EQUAL(lob.getVolumeAt(1, k), unpruned.getVolumeAt(1, k));
+        volume += lob.getVolumeAt(1, k);
+    }
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), volume, EPSILON);
+    BOOST_CHECK_EQUAL(unpruned.getNumLevels(1), 100); // copies sharing chunks are untouched
+}
+
+BOOST_AUTO_TEST_CASE(test_prune_dust)
+{
+    std::vector<double> ask_prices = {100.1, 100.2, 101.0, 103.0};
+    std::vector<double> ask_volumes = {10.0, 1e-3, 10.0, 10.0};
+    std::vector<double> bid_prices = {99.9, 95.0};
+    std::vector<double> bid_volumes = {1e-3, 10.0};
+    LOB lob(1.0, ask_prices, ask_volumes, bid_prices, bid_volumes);
+    lob.setPruning(0.01);
+    lob.DecayOrders();
+
+    // 100.2 starts as dust and 103.0 and 95.0 decay to it; the best bid stays however small
+    BOOST_CHECK_EQUAL(lob.getNumLevels(1), 2);
+    BOOST_CHECK_CLOSE(lob.getPriceAt(1, 1), 101.0, EPSILON);
+    BOOST_CHECK_EQUAL(lob.getNumLevels(-1), 1);
+    BOOST_CHECK_CLOSE(lob.bid(), 99.9, EPSILON);
+    BOOST_CHECK_CLOSE(lob.getTotalVolume(1), lob.getVolumeAt(1, 0) + lob.getVolumeAt(1, 1), EPSILON);
+
+    // pruning off leaves every level in place
+    lob.setPruning(0.0);
+    lob.AddLimitOrder(1, 100.4, 1e-3);
+    lob.DecayOrders();
+    BOOST_CHECK_EQUAL(lob.getNumLevels(1), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,177 @@
+// test_order_queue.cpp
+#define BOOST_TEST_MODULE OrderQueueTest
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <random>
+#include "../libs/OrderQueue.hpp"
+
+const double EPSILON = 1e-9;
+
+BOOST_AUTO_TEST_SUITE(OrderQueueTests)
+
+BOOST_AUTO_TEST_CASE(test_fifo_consume)
+{
+    OrderQueues queues;
+    OrderHandle a = queues.Push(1, 1000, 10.0, 0.0);
+    OrderHandle b = queues.Push(1, 1000, 30.0, 10.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 2);
+    BOOST_CHECK_CLOSE(queues.Share(a), 0.25, EPSILON);
+    BOOST_CHECK_EQUAL(queues.ShareAhead(a), 0.0);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(b), 0.25, EPSILON);
+
+    // the oldest order is filled first
+    queues.Consume(1, 1000, 15.0, 40.0);
+    BOOST_CHECK_EQUAL(queues.Share(a), 0.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 1);
+    BOOST_CHECK_CLOSE(queues.Share(b), 1.0, EPSILON);
+
+    queues.Consume(1, 1000, 25.0, 25.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 0);
+    BOOST_CHECK_EQUAL(queues.Share(b), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_volume_ahead_of_queueing)
+{
+    OrderQueues queues;
+    // the level already held 50 when queueing began
+    OrderHandle a = queues.Push(-1, 990, 25.0, 50.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(-1, 990), 2);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(a), 2.0 / 3.0, EPSILON);
+    BOOST_CHECK_CLOSE(queues.Share(a), 1.0 / 3.0, EPSILON);
+
+    // anonymous cancels come off the back
+    queues.Trim(-1, 990, 15.0, 75.0);
+    BOOST_CHECK_CLOSE(queues.Share(a) * 60.0, 10.0, EPSILON);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(a) * 60.0, 50.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_remove_by_handle)
+{
+    OrderQueues queues(8);
+    BOOST_CHECK(queues.Capacity() >= 8);
+    OrderHandle a = queues.Push(1, 1000, 10.0, 0.0);
+    OrderHandle b = queues.Push(1, 1000, 20.0, 10.0);
+    OrderHandle c = queues.Push(1, 1000, 30.0, 30.0);
+
+    // the level has since decayed to half, which scales every order alike
+    BOOST_CHECK_CLOSE(queues.Remove(b, 30.0), 10.0, EPSILON);
+    BOOST_CHECK_EQUAL(queues.Remove(b, 20.0), 0.0); // already gone
+    BOOST_CHECK_CLOSE(queues.Share(a), 0.25, EPSILON);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(c), 0.25, EPSILON);
+
+    int s = 0;
+    long long t = 0;
+    BOOST_CHECK(queues.Locate(c, s, t));
+    BOOST_CHECK_EQUAL(s, 1);
+    BOOST_CHECK_EQUAL(t, 1000);
+
+    // the freed node is recycled, and the old handle does not reach the new order
+    OrderHandle d = queues.Push(-1, 990, 5.0, 0.0);
+    BOOST_CHECK_EQUAL(d.node, b.node);
+    BOOST_CHECK(!queues.Locate(b, s, t));
+    BOOST_CHECK_CLOSE(queues.Share(d), 1.0, EPSILON);
+
+    queues.Clear(1, 1000);
+    BOOST_CHECK_EQUAL(queues.Share(a), 0.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 0);
+    BOOST_CHECK(!OrderHandle().IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(test_position_through_every_change)
+{
+    OrderQueues queues;
+    OrderHandle a = queues.Push(1, 1000, 10.0, 0.0);
+    OrderHandle b = queues.Push(1, 1000, 20.0, 10.0);
+    OrderHandle c = queues.Push(1, 1000, 30.0, 30.0);
+    OrderHandle d = queues.Push(1, 1000, 40.0, 60.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 4);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(d), 0.6, EPSILON);
+
+    // part of the head is executed, then an order in the middle and one at the back leave
+    queues.Consume(1, 1000, 4.0, 100.0);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(c) * 96.0, 26.0, EPSILON);
+    BOOST_CHECK_CLOSE(queues.Remove(b, 96.0), 20.0, EPSILON);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 3);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(c) * 76.0, 6.0, EPSILON);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(d) * 76.0, 36.0, EPSILON);
+    queues.Trim(1, 1000, 40.0, 76.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 2);
+    BOOST_CHECK_EQUAL(queues.Share(d), 0.0);
+    BOOST_CHECK_CLOSE(queues.ShareAhead(c) * 36.0, 6.0, EPSILON);
+
+    // the rest of the head goes, and the next order is at the front
+    queues.Consume(1, 1000, 6.0, 36.0);
+    BOOST_CHECK_EQUAL(queues.QueueLength(1, 1000), 1);
+    BOOST_CHECK_EQUAL(queues.Share(a), 0.0);
+    BOOST_CHECK_EQUAL(queues.ShareAhead(c), 0.0);
+    BOOST_CHECK_CLOSE(queues.Share(c), 1.0, EPSILON);
+}
+
+BOOST_AUTO_TEST_CASE(test_positions_match_a_walk_of_the_queue)
+{
+    // many levels on both sides, with enough turnover to recycle levels and rebuild their trees
+    OrderQueues queues;
+    std::default_random_engine generator(3);
+    std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+    std::map<std::pair<int, long long>, std::vector<OrderHandle>> arrivals;
+    std::map<std::pair<int, long long>, double> volumes;
+    for (int n = 0; n < 20000; n++)
+    {
+        const int s = uni_dist(generator) < 0.5 ? 1 : -1;
+        const long long t = static_cast<long long>(60 * uni_dist(generator)) * 1000003LL - 30000000LL;
+        const std::pair<int, long long> key(s, t);
+        double &v_level = volumes[key];
+        std::vector<OrderHandle> &hs = arrivals[key];
+        const double u = uni_dist(generator);
+        if (u < 0.5 || v_level <= 0.0)
+        {
+            const double v = 1.0 + 9.0 * uni_dist(generator);
+            if (v_level <= 0.0)
+                hs.clear();
+            hs.push_back(queues.Push(s, t, v, v_level));
+            v_level += v;
+        }
+        else if (u < 0.65)
+        {
+            const double v = std::min(v_level, 8.0 * uni_dist(generator));
+            queues.Consume(s, t, v, v_level);
+            v_level -= v;
+        }
+        else if (u < 0.75)
+        {
+            const double v = std::min(v_level, 8.0 * uni_dist(generator));
+            queues.Trim(s, t, v, v_level);
+            v_level -= v;
+        }
+        else if (u < 0.99)
+        {
+            const OrderHandle &h = hs[static_cast<size_t>(hs.size() * uni_dist(generator))];
+            v_level -= queues.Remove(h, v_level);
+        }
+        else
+        {
+            queues.Clear(s, t);
+            v_level = 0.0;
+        }
+        if (v_level < 1e-9)
+        {
+            queues.Clear(s, t);
+            v_level = 0.0;
+        }
+
+        int live = 0;
+        double ahead = 0.0;
+        for (const OrderHandle &h : hs)
+        {
+            const double share = queues.Share(h);
+            if (share <= 0.0)
+                continue;
+            live++;
+            BOOST_CHECK_SMALL(queues.ShareAhead(h) - ahead, 1e-9);
+            ahead += share;
+        }
+        BOOST_CHECK_EQUAL(queues.QueueLength(s, t), live);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
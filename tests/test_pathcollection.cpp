@@ -44,11 +44,11 @@ BOOST_AUTO_TEST_CASE(test_backward_compatibility_case_1)
     std::vector<double> res;
     paths.CalcLiquidityMetrics(res);
 
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[0]), std::string("0.1000"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[1]), std::string("0.0024"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[2]), std::string("0.0275"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[3]), std::string("0.0632"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[4]), std::string("0.0001"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[0]), std::string("0.5000"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[1]), std::string("0.0026"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[2]), std::string("0.1316"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[3]), std::string("0.0440"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[4]), std::string("0.0020"));
 }
 
 BOOST_AUTO_TEST_CASE(test_backward_compatibility_case_2)
@@ -88,10 +88,38 @@ BOOST_AUTO_TEST_CASE(test_backward_compatibility_case_2)
     paths.CalcLiquidityMetrics(res);
 
     BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[0]), std::string("0.0000"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[1]), std::string("0.0024"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[2]), std::string("0.0333"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[3]), std::string("0.0567"));
-    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[4]), std::string("0.1642"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[1]), std::string("0.0025"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[2]), std::string("0.0518"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[3]), std::string("0.0542"));
+    BOOST_CHECK_EQUAL(boost::str(boost::format("%1$.4f") % res[4]), std::string("0.0447"));
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_SUITE_END()
+
+// paths on a LadderLOB see the same flow as on a LOB and end with the same metrics
+BOOST_AUTO_TEST_SUITE(LadderPathCollectionTests)
+
+BOOST_AUTO_TEST_CASE(test_ladder_paths_match_lob_paths)
+{
+    const std::vector<double> aps0 = {5.02, 5.04, 5.06};
+    const std::vector<double> avs0(aps0.size(), 10.0);
+    const std::vector<double> bps0 = {4.94, 4.96, 4.98};
+    const std::vector<double> bvs0(bps0.size(), 10.0);
+    const LOB lob0(0.0, aps0, avs0, bps0, bvs0);
+    const LadderLOB ladder0(0.0, aps0, avs0, bps0, bvs0);
+    RandomInfo ri(9999, 0.1, 1.0, 0.25, 0.3, 0, 1, -0.1, 0.1, 0.5);
+
+    PathCollection paths(10, PathInfo(5, 5, 4, 5.0, lob0, 10, 0.089), ri);
+    LadderPathCollection ladder_paths(10, LadderPathInfo(5, 5, 4, 5.0, ladder0, 10, 0.089), ri);
+    paths.GeneratePaths();
+    ladder_paths.GeneratePaths();
+    std::vector<double> res, ladder_res;
+    paths.CalcLiquidityMetrics(res);
+    ladder_paths.CalcLiquidityMetrics(ladder_res);
+
+    BOOST_REQUIRE_EQUAL(res.size(), ladder_res.size());
+    for (size_t i = 0; i < res.size(); i++)
+        BOOST_CHECK_CLOSE(res[i], ladder_res[i], 1e-6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
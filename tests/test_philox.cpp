@@ -0,0 +1,102 @@
+// test_philox.cpp
+#define BOOST_TEST_MODULE PhiloxTest
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <random>
+#include "../libs/Philox.hpp"
+
+BOOST_AUTO_TEST_SUITE(PhiloxTests)
+
+// known answers of Philox4x32-10 from the Random123 distribution
+BOOST_AUTO_TEST_CASE(test_known_answers)
+{
+    uint32_t out[4];
+    const uint32_t c0[4] = {0, 0, 0, 0};
+    const uint32_t k0[2] = {0, 0};
+    Philox4x32::Block(c0, k0, out);
+    BOOST_CHECK_EQUAL(out[0], 0x6627e8d5u);
+    BOOST_CHECK_EQUAL(out[1], 0xe169c58du);
+    BOOST_CHECK_EQUAL(out[2], 0xbc57ac4cu);
+    BOOST_CHECK_EQUAL(out[3], 0x9b00dbd8u);
+
+    const uint32_t c1[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+    const uint32_t k1[2] = {0xffffffff, 0xffffffff};
+    Philox4x32::Block(c1, k1, out);
+    BOOST_CHECK_EQUAL(out[0], 0x408f276du);
+    BOOST_CHECK_EQUAL(out[3], 0x6d5451fdu);
+
+    const uint32_t c2[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+    const uint32_t k2[2] = {0xa4093822, 0x299f31d0};
+    Philox4x32::Block(c2, k2, out);
+    BOOST_CHECK_EQUAL(out[0], 0xd16cfe09u);
+    BOOST_CHECK_EQUAL(out[3], 0x24126ea1u);
+
+    // the engine hands out the blocks of its counter in order
+    Philox4x32 engine(0, 0);
+    BOOST_CHECK_EQUAL(engine(), 0x6627e8d5u);
+    BOOST_CHECK_EQUAL(engine(), 0xe169c58du);
+}
+
+BOOST_AUTO_TEST_CASE(test_jump_ahead)
+{
+    Philox4x32 stepped(42, 7);
+    std::vector<uint32_t> outputs;
+    for (int i = 0; i < 1024; i++)
+        outputs.push_back(stepped());
+    BOOST_CHECK_EQUAL(stepped.Position(), 1024);
+
+    for (int z : {0, 1, 3, 4, 5, 517, 998})
+    {
+        Philox4x32 jumped(42, 7);
+        jumped.discard(z);
+        BOOST_CHECK_EQUAL(jumped.Position(), z);
+        BOOST_CHECK_EQUAL(jumped(), outputs[z]);
+        // and again from the middle of a block
+        jumped.discard(z % 3);
+        BOOST_CHECK_EQUAL(jumped(), outputs[z + 1 + z % 3]);
+    }
+
+    // bulk generation picks up mid-block and carries on where it stops
+    Philox4x32 bulk(42, 7);
+    bulk.discard(3);
+    std::vector<uint32_t> out(18);
+    bulk.Generate(out.data(), 18);
+    for (int i = 0; i < 18; i++)
+        BOOST_CHECK_EQUAL(out[i], outputs[3 + i]);
+    BOOST_CHECK_EQUAL(bulk(), outputs[21]);
+
+    Philox4x32 sought(42, 0);
+    sought.Seek(7, 321);
+    BOOST_CHECK_EQUAL(sought(), outputs[321]);
+}
+
+BOOST_AUTO_TEST_CASE(test_streams_are_distinct)
+{
+    Philox4x32 a(1, 0), b(1, 1), c(2, 0);
+    int same_ab = 0, same_ac = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        uint32_t x = a(), y = b(), z = c();
+        same_ab += x == y;
+        same_ac += x == z;
+    }
+    BOOST_CHECK_EQUAL(same_ab, 0);
+    BOOST_CHECK_EQUAL(same_ac, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_with_distributions)
+{
+    Philox4x32 engine(2024, 0);
+    std::uniform_real_distribution<double> uni_dist(0.0, 1.0);
+    const int n = 100000;
+    double mean = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        double u = uni_dist(engine);
+        BOOST_REQUIRE(u >= 0.0 && u < 1.0);
+        mean += u;
+    }
+    BOOST_CHECK_SMALL(mean / n - 0.5, 0.01);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
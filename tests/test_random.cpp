@@ -4,6 +4,7 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include "../libs/Random.hpp"
 
 const double EPSILON = 1e-9;
@@ -453,4 +454,504 @@ BOOST_AUTO_TEST_CASE(test_equal_mid_and_fundamental_prices)
     BOOST_CHECK(s == 1 || s == -1);
 }
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_SUITE_END()
+// Test the counter-based engine and its streams
+BOOST_AUTO_TEST_SUITE(RandomPhiloxTests)
+
+BOOST_AUTO_TEST_CASE(test_paths_in_any_order)
+{
+    RandomInfo ri(12345, 0.01, 5.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    ri.engine = PHILOX_ENGINE;
+
+    // draw paths 0 to 3 in turn, then path 2 on its own
+    std::vector<double> prices;
+    for (int i = 0; i < 4; i++)
+    {
+        Random rng(ri.ForPath(i));
+        prices.push_back(rng.GenerateShockedPrice(100.0));
+    }
+    Random rng2(ri.ForPath(2));
+    BOOST_CHECK_EQUAL(rng2.GenerateShockedPrice(100.0), prices[2]);
+    BOOST_CHECK_NE(prices[0], prices[1]);
+    BOOST_CHECK_EQUAL(ri.ForPath(2).seed, ri.seed);
+
+    // the original engine keeps stepping the seed
+    ri.engine = MINSTD_ENGINE;
+    BOOST_CHECK_EQUAL(ri.ForPath(2).seed, ri.seed + 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_jump_ahead)
+{
+    RandomInfo ri(777, 0.01, 5.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    ri.engine = PHILOX_ENGINE;
+    Random once(ri), twice(ri);
+    once.JumpAhead(1000000);
+    twice.JumpAhead(400000);
+    twice.JumpAhead(600000);
+    for (int i = 0; i < 10; i++)
+    {
+        BOOST_CHECK_EQUAL(once.GenerateNumOrders(), twice.GenerateNumOrders());
+        BOOST_CHECK_EQUAL(once.GenerateShockedPrice(100.0), twice.GenerateShockedPrice(100.0));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_philox_order_statistics)
+{
+    RandomInfo ri(12345, 0.01, 5.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    ri.engine = PHILOX_ENGINE;
+    Random rng(ri);
+    const int n = 20000;
+    int n_limit = 0;
+    double orders = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        OrderType o_type;
+        double p, v;
+        int s;
+        rng.GenerateOrder(o_type, p, v, s, 100.0, 100.0);
+        n_limit += o_type == LIMITORDER;
+        BOOST_REQUIRE(v >= 10.0 && v <= 100.0);
+        orders += rng.GenerateNumOrders();
+    }
+    BOOST_CHECK_SMALL((double)n_limit / n - 0.7, 0.02);
+    BOOST_CHECK_SMALL(orders / n - 5.0, 0.1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Test drawing a run of orders in bulk
+BOOST_AUTO_TEST_SUITE(RandomBatchTests)
+
+BOOST_AUTO_TEST_CASE(test_batch_order_statistics)
+{
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        RandomInfo ri(2024, 0.01, 5.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.4);
+        ri.engine = static_cast<RandomEngine>(engine);
+        Random rng(ri);
+        OrderDraws draws;
+        const int n = 50001; // odd, for the unpaired normal
+        rng.GenerateOrders(n, draws);
+        BOOST_CHECK_EQUAL(draws.Size(), n);
+
+        int n_limit = 0, n_informed = 0, n_buy = 0;
+        double v_mean = 0.0, spread_mean = 0.0, spread_var = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            n_limit += draws.limit[i];
+            n_informed += draws.informed[i];
+            n_buy += draws.s[i] > 0;
+            BOOST_REQUIRE(draws.v[i] >= 10.0 && draws.v[i] < 100.0);
+            BOOST_REQUIRE(std::isfinite(draws.spread[i]));
+            v_mean += draws.v[i];
+            spread_mean += draws.spread[i];
+            spread_var += (draws.spread[i] - 0.5) * (draws.spread[i] - 0.5);
+        }
+        BOOST_CHECK_SMALL((double)n_limit / n - 0.7, 0.01);
+        BOOST_CHECK_SMALL((double)n_informed / n - 0.3, 0.01);
+        BOOST_CHECK_SMALL((double)n_buy / n - 0.4, 0.01);
+        BOOST_CHECK_SMALL(v_mean / n - 55.0, 0.5);
+        BOOST_CHECK_SMALL(spread_mean / n - 0.5, 0.005);
+        BOOST_CHECK_SMALL(std::sqrt(spread_var / n) - 0.1, 0.005);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_order_mapping)
+{
+    OrderDraws draws;
+    draws.limit = {1, 1, 0, 0};
+    draws.informed = {0, 1, 0, 1};
+    draws.s = {1, -1, -1, -1};
+    draws.v = {10.0, 20.0, 30.0, 40.0};
+    draws.spread = {0.5, 0.25, 0.0, 0.0};
+
+    OrderType o_type;
+    double p = 0.0, v;
+    int s;
+    draws.Order(0, o_type, p, v, s, 100.0, 99.0);
+    BOOST_CHECK_EQUAL(o_type, LIMITORDER);
+    BOOST_CHECK_CLOSE(p, 99.5, EPSILON); // uninformed quotes around the mid
+    draws.Order(1, o_type, p, v, s, 100.0, 99.0);
+    BOOST_CHECK_CLOSE(p, 99.25, EPSILON); // informed around the fundamentals
+    BOOST_CHECK_EQUAL(s, -1);
+    draws.Order(2, o_type, p, v, s, 100.0, 99.0);
+    BOOST_CHECK_EQUAL(o_type, MARKETORDER);
+    BOOST_CHECK_EQUAL(s, -1);
+    BOOST_CHECK_CLOSE(v, 30.0, EPSILON);
+    draws.Order(3, o_type, p, v, s, 100.0, 99.0);
+    BOOST_CHECK_EQUAL(s, 1); // informed sell above the fundamentals
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Test the Ziggurat normal sampler against the moments and tails of the standard normal
+BOOST_AUTO_TEST_SUITE(RandomZigguratTests)
+
+void CheckStandardNormal(const std::vector<double> &z)
+{
+    const double n = z.size();
+    double mean = 0.0;
+    for (double x : z)
+        mean += x;
+    mean /= n;
+    double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    int below = 0, beyond2 = 0, beyond3 = 0, in_tail = 0;
+    for (double x : z)
+    {
+        const double d = x - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+        below += x < -1.0;
+        beyond2 += std::fabs(x) > 2.0;
+        beyond3 += std::fabs(x) > 3.0;
+        in_tail += std::fabs(x) > 3.442619855899; // drawn from the base layer's tail
+    }
+    m2 /= n;
+    m3 /= n;
+    m4 /= n;
+    BOOST_CHECK_SMALL(mean, 0.01);
+    BOOST_CHECK_SMALL(m2 - 1.0, 0.015);
+    BOOST_CHECK_SMALL(m3 / std::pow(m2, 1.5), 0.03);
+    BOOST_CHECK_SMALL(m4 / (m2 * m2) - 3.0, 0.06);
+    BOOST_CHECK_SMALL(below / n - 0.158655, 0.003);
+    BOOST_CHECK_SMALL(beyond2 / n - 0.045500, 0.002);
+    BOOST_CHECK_SMALL(beyond3 / n - 0.002700, 0.0006);
+    BOOST_CHECK_SMALL(in_tail / n - 0.000576, 0.0003);
+}
+
+BOOST_AUTO_TEST_CASE(test_ziggurat_scalar_statistics)
+{
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        RandomInfo ri(31415, 1.0, 5.0, 0.7, 0.3, 10.0, 100.0, 0.0, 1.0, 0.5);
+        ri.engine = static_cast<RandomEngine>(engine);
+        ri.normal = ZIGGURAT_NORMAL;
+        Random rng(ri);
+        std::vector<double> z(200000);
+        for (double &x : z)
+            x = rng.GenerateShockedPrice(0.0);
+        CheckStandardNormal(z);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ziggurat_bulk_statistics)
+{
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        RandomInfo ri(27182, 1.0, 5.0, 0.7, 0.3, 10.0, 100.0, 0.0, 1.0, 0.5);
+        ri.engine = static_cast<RandomEngine>(engine);
+        ri.normal = ZIGGURAT_NORMAL;
+        Random rng(ri);
+        OrderDraws draws;
+        rng.GenerateOrders(200001, draws);
+        CheckStandardNormal(draws.spread);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ziggurat_deterministic_and_default)
+{
+    RandomInfo ri(4242, 0.01, 5.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    BOOST_CHECK_EQUAL(ri.normal, POLAR_NORMAL);
+
+    // the default sampler leaves the original draws untouched
+    Random original(ri.seed, ri.vol_news, ri.order_intensity, ri.prob_otype, ri.prob_info,
+                    ri.v_min, ri.v_max, ri.mean_spread, ri.vol_spread, ri.prob_sign);
+    Random polar(ri);
+    for (int i = 0; i < 100; i++)
+        BOOST_CHECK_EQUAL(original.GenerateShockedPrice(100.0), polar.GenerateShockedPrice(100.0));
+
+    ri.normal = ZIGGURAT_NORMAL;
+    Random zig1(ri), zig2(ri);
+    for (int i = 0; i < 100; i++)
+        BOOST_CHECK_EQUAL(zig1.GenerateShockedPrice(100.0), zig2.GenerateShockedPrice(100.0));
+}
+
+// throughput of the samplers, reported with --log_level=message; not a pass criterion
+BOOST_AUTO_TEST_CASE(test_normal_sampler_throughput)
+{
+    const int n = 1000000;
+    std::vector<double> z(n);
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        for (int normal = POLAR_NORMAL; normal <= ZIGGURAT_NORMAL; normal++)
+        {
+            RandomInfo ri(1, 1.0, 5.0, 0.7, 0.3, 10.0, 100.0, 0.0, 1.0, 0.5);
+            ri.engine = static_cast<RandomEngine>(engine);
+            ri.normal = static_cast<NormalSampler>(normal);
+            Random rng(ri);
+            auto start = std::chrono::steady_clock::now();
+            for (double &x : z)
+                x = rng.GenerateShockedPrice(0.0);
+            auto mid = std::chrono::steady_clock::now();
+            OrderDraws draws;
+            rng.GenerateOrders(n, draws);
+            auto end = std::chrono::steady_clock::now();
+            const double scalar_ns = std::chrono::duration<double, std::nano>(mid - start).count() / n;
+            const double bulk_ns = std::chrono::duration<double, std::nano>(end - mid).count() / n;
+            BOOST_TEST_MESSAGE((engine == PHILOX_ENGINE ? "philox " : "minstd ")
+                               << (normal == ZIGGURAT_NORMAL ? "ziggurat" : "polar/box-muller")
+                               << ": scalar " << scalar_ns << " ns/draw, bulk orders " << bulk_ns << " ns/order");
+            BOOST_CHECK(std::isfinite(z[n - 1]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Test the constant-time Poisson sampler against the exact distribution
+BOOST_AUTO_TEST_SUITE(RandomPoissonTests)
+
+// chi-square of counts against Poisson(mu), over bins of at least 5 expected samples with the tails pooled
+void CheckPoisson(const std::vector<int> &counts, double mu)
+{
+    const double n = counts.size();
+    int k_max = 0;
+    double mean = 0.0, var = 0.0;
+    for (int k : counts)
+    {
+        BOOST_REQUIRE(k >= 0);
+        k_max = std::max(k_max, k);
+        mean += k;
+    }
+    mean /= n;
+    for (int k : counts)
+        var += (k - mean) * (k - mean);
+    var /= n;
+    BOOST_CHECK_SMALL(mean - mu, 5.0 * std::sqrt(mu / n));
+    BOOST_CHECK_SMALL(var / mu - 1.0, 5.0 * std::sqrt(2.0 / n));
+
+    std::vector<double> observed(k_max + 1, 0.0);
+    for (int k : counts)
+        observed[k]++;
+    double chi2 = 0.0, expected_bin = 0.0, observed_bin = 0.0, cdf = 0.0;
+    int df = -1;
+    for (int k = 0; k <= k_max; k++)
+    {
+        const double pk = std::exp(-mu + k * std::log(mu) - Poisson::LogFactorial(k));
+        cdf += pk;
+        expected_bin += n * pk;
+        observed_bin += observed[k];
+        if (expected_bin >= 5.0 && n * (1.0 - cdf) >= 5.0)
+        {
+            chi2 += (observed_bin - expected_bin) * (observed_bin - expected_bin) / expected_bin;
+            df++;
+            expected_bin = observed_bin = 0.0;
+        }
+    }
+    expected_bin += n * (1.0 - cdf); // upper tail beyond k_max
+    chi2 += (observed_bin - expected_bin) * (observed_bin - expected_bin) / expected_bin;
+    df++;
+    BOOST_CHECK_LT(chi2, df + 5.0 * std::sqrt(2.0 * df)); // far out in the chi-square tail
+}
+
+BOOST_AUTO_TEST_CASE(test_log_factorial)
+{
+    const int ks[] = {0, 1, 2, 10, 255, 256, 257, 1000, 1000000};
+    for (int k : ks)
+        BOOST_CHECK_CLOSE(Poisson::LogFactorial(k) + 1.0, std::lgamma(k + 1.0) + 1.0, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(test_ptrs_scalar_distribution)
+{
+    const double mus[] = {0.5, 3.0, 9.9, 10.0, 40.0, 400.0, 5000.0};
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        for (double mu : mus)
+        {
+            RandomInfo ri(8080, 0.01, mu, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+            ri.engine = static_cast<RandomEngine>(engine);
+            ri.counts = PTRS_POISSON;
+            Random rng(ri);
+            std::vector<int> counts(100000);
+            for (int &k : counts)
+                k = rng.GenerateNumOrders();
+            CheckPoisson(counts, mu);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ptrs_batch_distribution)
+{
+    const double mus[] = {3.0, 40.0, 400.0};
+    for (int engine = MINSTD_ENGINE; engine <= PHILOX_ENGINE; engine++)
+    {
+        for (double mu : mus)
+        {
+            RandomInfo ri(9090, 0.01, mu, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+            ri.engine = static_cast<RandomEngine>(engine);
+            ri.counts = PTRS_POISSON;
+            Random rng(ri);
+            std::vector<int> counts, batch;
+            for (int i = 0; i < 1000; i++)
+            {
+                rng.GenerateNumOrders(100, batch);
+                BOOST_REQUIRE_EQUAL(batch.size(), 100u);
+                counts.insert(counts.end(), batch.begin(), batch.end());
+            }
+            CheckPoisson(counts, mu);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_ptrs_zero_intensity_and_default)
+{
+    RandomInfo ri(12345, 0.01, 0.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    BOOST_CHECK_EQUAL(ri.counts, STD_POISSON);
+    ri.counts = PTRS_POISSON;
+    Random rng(ri);
+    BOOST_CHECK_EQUAL(rng.GenerateNumOrders(), 0);
+
+    // the default sampler leaves the original draws untouched
+    Random original(12345, 0.01, 40.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1);
+    RandomInfo ri_std(12345, 0.01, 40.0, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+    Random standard(ri_std);
+    for (int i = 0; i < 100; i++)
+        BOOST_CHECK_EQUAL(original.GenerateNumOrders(), standard.GenerateNumOrders());
+}
+
+// throughput of the samplers as the intensity grows, reported with --log_level=message; not a pass criterion
+BOOST_AUTO_TEST_CASE(test_poisson_sampler_throughput)
+{
+    const int n = 200000;
+    const double mus[] = {40.0, 400.0, 4000.0};
+    for (double mu : mus)
+    {
+        for (int sampler = STD_POISSON; sampler <= PTRS_POISSON; sampler++)
+        {
+            RandomInfo ri(1, 0.01, mu, 0.7, 0.3, 10.0, 100.0, 0.5, 0.1, 0.5);
+            ri.engine = PHILOX_ENGINE;
+            ri.counts = static_cast<CountSampler>(sampler);
+            Random rng(ri);
+            long long total = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < n; i++)
+                total += rng.GenerateNumOrders();
+            auto end = std::chrono::steady_clock::now();
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count() / n;
+            BOOST_TEST_MESSAGE((sampler == PTRS_POISSON ? "ptrs" : "std") << " mean " << mu << ": " << ns << " ns/draw");
+            BOOST_CHECK_GT(total, 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Test common random numbers across scenarios from per-component substreams
+BOOST_AUTO_TEST_SUITE(RandomSubstreamTests)
+
+RandomInfo SubstreamInfo(double prob_otype, bool substreams)
+{
+    RandomInfo ri(2718, 0.01, 40.0, prob_otype, 0.25, 0.0, 1.0, -0.1, 0.1, 0.5);
+    ri.engine = PHILOX_ENGINE;
+    ri.substreams = substreams;
+    return ri;
+}
+
+BOOST_AUTO_TEST_CASE(test_orders_coupled_across_parameters)
+{
+    Random low(SubstreamInfo(0.6, true)), high(SubstreamInfo(0.65, true));
+    const int n = 10000;
+    int n_flipped = 0;
+    for (int i = 0; i < n; i++)
+    {
+        OrderType t_low, t_high;
+        double p_low = 0.0, p_high = 0.0, v_low, v_high;
+        int s_low, s_high;
+        low.GenerateOrder(t_low, p_low, v_low, s_low, 5.0, 4.9);
+        high.GenerateOrder(t_high, p_high, v_high, s_high, 5.0, 4.9);
+        BOOST_REQUIRE_EQUAL(low.GenerateShockedPrice(5.0), high.GenerateShockedPrice(5.0));
+        BOOST_REQUIRE_EQUAL(low.GenerateNumOrders(), high.GenerateNumOrders());
+        // only the type moves with its probability, and only from market to limit
+        BOOST_REQUIRE_EQUAL(v_low, v_high);
+        if (t_low != t_high)
+        {
+            BOOST_REQUIRE_EQUAL(t_high, LIMITORDER);
+            n_flipped++;
+            continue;
+        }
+        BOOST_REQUIRE_EQUAL(s_low, s_high);
+        if (t_low == LIMITORDER)
+            BOOST_REQUIRE_EQUAL(p_low, p_high);
+    }
+    BOOST_CHECK_SMALL((double)n_flipped / n - 0.05, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(test_single_stream_desynchronizes)
+{
+    Random low(SubstreamInfo(0.6, false)), high(SubstreamInfo(0.65, false));
+    const int n = 1000;
+    int n_same = 0;
+    for (int i = 0; i < n; i++)
+    {
+        OrderType o_type;
+        double p, v_low, v_high;
+        int s;
+        low.GenerateOrder(o_type, p, v_low, s, 5.0, 4.9);
+        high.GenerateOrder(o_type, p, v_high, s, 5.0, 4.9);
+        n_same += v_low == v_high;
+    }
+    // a skipped sign draw shifts every later draw of one of them
+    BOOST_CHECK_LT(n_same, n / 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_orders_coupled_across_parameters)
+{
+    for (int normal = POLAR_NORMAL; normal <= ZIGGURAT_NORMAL; normal++)
+    {
+        RandomInfo ri_low = SubstreamInfo(0.6, true), ri_high = SubstreamInfo(0.65, true);
+        ri_low.prob_info = 0.2;
+        ri_low.normal = ri_high.normal = static_cast<NormalSampler>(normal);
+        ri_low.counts = ri_high.counts = PTRS_POISSON;
+        Random low(ri_low), high(ri_high);
+        OrderDraws d_low, d_high;
+        std::vector<int> n_low, n_high;
+        for (int quar = 0; quar < 10; quar++)
+        {
+            low.GenerateNumOrders(4, n_low);
+            high.GenerateNumOrders(4, n_high);
+            BOOST_REQUIRE(n_low == n_high);
+            low.GenerateOrders(n_low[0], d_low);
+            high.GenerateOrders(n_high[0], d_high);
+            BOOST_REQUIRE(d_low.s == d_high.s);
+            BOOST_REQUIRE(d_low.v == d_high.v);
+            BOOST_REQUIRE(d_low.spread == d_high.spread);
+            for (int i = 0; i < d_low.Size(); i++)
+            {
+                BOOST_REQUIRE(d_low.limit[i] <= d_high.limit[i]);
+                BOOST_REQUIRE(d_low.informed[i] <= d_high.informed[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_substream_statistics_and_paths)
+{
+    Random rng(SubstreamInfo(0.7, true));
+    const int n = 20000;
+    int n_limit = 0, n_buy = 0;
+    double v_mean = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        OrderType o_type;
+        double p, v;
+        int s;
+        rng.GenerateOrder(o_type, p, v, s, 5.0, 5.0);
+        n_limit += o_type == LIMITORDER;
+        n_buy += s > 0;
+        v_mean += v;
+    }
+    BOOST_CHECK_SMALL((double)n_limit / n - 0.7, 0.02);
+    BOOST_CHECK_SMALL((double)n_buy / n - 0.5 * (1.0 - 0.3 * 0.25), 0.02); // informed market orders sell at the fundamentals
+    BOOST_CHECK_SMALL(v_mean / n - 0.5, 0.01);
+
+    // paths of a collection keep drawing from streams of their own
+    RandomInfo ri = SubstreamInfo(0.7, true);
+    Random path0(ri.ForPath(0)), path1(ri.ForPath(1));
+    BOOST_CHECK_NE(path0.GenerateShockedPrice(5.0), path1.GenerateShockedPrice(5.0));
+
+    ri.engine = MINSTD_ENGINE;
+    BOOST_CHECK_THROW(Random bad(ri), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
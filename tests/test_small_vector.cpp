@@ -0,0 +1,120 @@
+// test_small_vector.cpp
+#define BOOST_TEST_MODULE SmallVectorTest
+#include <boost/test/included/unit_test.hpp>
+#include <string>
+#include <memory>
+#include <vector>
+#include "../libs/SmallVector.hpp"
+
+BOOST_AUTO_TEST_SUITE(SmallVectorTests)
+
+BOOST_AUTO_TEST_CASE(test_stays_inline)
+{
+    SmallVector<int, 4> v;
+    for (int i = 0; i < 4; i++)
+        v.push_back(i);
+    BOOST_CHECK_EQUAL(v.size(), 4);
+    BOOST_CHECK_EQUAL(v.capacity(), 4);
+
+    SmallVector<int, 4> copy(v);
+    copy[0] = 10;
+    BOOST_CHECK_EQUAL(v[0], 0);
+    BOOST_CHECK_EQUAL(copy[0], 10);
+    BOOST_CHECK_EQUAL(copy.back(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_spills_to_heap)
+{
+    SmallVector<int, 2> v;
+    for (int i = 0; i < 10; i++)
+        v.push_back(i);
+    BOOST_CHECK_EQUAL(v.size(), 10);
+    BOOST_CHECK(v.capacity() >= 10);
+    for (int i = 0; i < 10; i++)
+        BOOST_CHECK_EQUAL(v[i], i);
+
+    SmallVector<int, 2> copy;
+    copy = v;
+    BOOST_CHECK_EQUAL(copy.size(), 10);
+    BOOST_CHECK_EQUAL(copy[9], 9);
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_erase)
+{
+    SmallVector<std::string, 3> v;
+    v.push_back("a");
+    v.push_back("c");
+    v.insert(v.begin() + 1, "b");
+    v.insert(v.end(), "d"); // spills
+    v.insert(v.begin(), "0");
+    BOOST_REQUIRE_EQUAL(v.size(), 5);
+    BOOST_CHECK_EQUAL(v[0], "0");
+    BOOST_CHECK_EQUAL(v[2], "b");
+    BOOST_CHECK_EQUAL(v[4], "d");
+
+    v.erase(v.begin() + 2);
+    BOOST_CHECK_EQUAL(v.size(), 4);
+    BOOST_CHECK_EQUAL(v[2], "c");
+    v.pop_back();
+    BOOST_CHECK_EQUAL(v.back(), "c");
+    v.resize(1);
+    BOOST_CHECK_EQUAL(v.size(), 1);
+    BOOST_CHECK_EQUAL(v[0], "0");
+}
+
+BOOST_AUTO_TEST_CASE(test_elements_are_destroyed)
+{
+    std::shared_ptr<int> p = std::make_shared<int>(1);
+    {
+        SmallVector<std::shared_ptr<int>, 2> v;
+        for (int i = 0; i < 5; i++)
+            v.push_back(p);
+        SmallVector<std::shared_ptr<int>, 2> copy(v);
+        BOOST_CHECK_EQUAL(p.use_count(), 11);
+        v.erase(v.begin());
+        BOOST_CHECK_EQUAL(p.use_count(), 10);
+    }
+    BOOST_CHECK_EQUAL(p.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_count_value_and_range)
+{
+    SmallVector<int, 4> v(3, 7);
+    BOOST_REQUIRE_EQUAL(v.size(), 3);
+    BOOST_CHECK_EQUAL(v[0], 7);
+    BOOST_CHECK_EQUAL(v[2], 7);
+
+    std::vector<int> src = {1, 2, 3, 4, 5};
+    SmallVector<int, 4> range(src.begin(), src.end());
+    BOOST_REQUIRE_EQUAL(range.size(), 5);
+    BOOST_CHECK_EQUAL(range[4], 5);
+}
+
+BOOST_AUTO_TEST_CASE(test_move)
+{
+    std::shared_ptr<int> p = std::make_shared<int>(1);
+    // spilled storage changes hands without touching the elements
+    SmallVector<std::shared_ptr<int>, 2> v(5, p);
+    const std::shared_ptr<int> *storage = v.data();
+    SmallVector<std::shared_ptr<int>, 2> moved(std::move(v));
+    BOOST_CHECK(moved.data() == storage);
+    BOOST_CHECK_EQUAL(moved.size(), 5);
+    BOOST_CHECK(v.empty());
+    BOOST_CHECK_EQUAL(v.capacity(), 2);
+    BOOST_CHECK_EQUAL(p.use_count(), 6);
+
+    // inline elements are moved one by one
+    SmallVector<std::shared_ptr<int>, 2> small(1, p);
+    moved = std::move(small);
+    BOOST_CHECK_EQUAL(moved.size(), 1);
+    BOOST_CHECK_EQUAL(moved.capacity(), 2);
+    BOOST_CHECK(small.empty());
+    BOOST_CHECK_EQUAL(p.use_count(), 2);
+
+    v.push_back(p);
+    v = std::move(moved);
+    BOOST_CHECK_EQUAL(v.size(), 1);
+    BOOST_CHECK_EQUAL(p.use_count(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()